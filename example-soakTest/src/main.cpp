@@ -0,0 +1,40 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#include "ofMain.h"
+#include "ofAppNoWindow.h"
+#include "ofApp.h"
+#include <cstdlib>
+
+//usage: soakTest [cycles] [max rss growth in MB], defaults to 10 million cycles and 64 MB
+int main(int argc, char *argv[])
+{
+    unsigned long long cycles = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000ULL;
+    size_t maxGrowthBytes = (argc > 2 ? strtoull(argv[2], NULL, 10) : 64ULL) * 1024 * 1024;
+    
+    ofAppNoWindow window;
+    ofSetupOpenGL(&window, 1024, 768, OF_WINDOW);
+    //ofExit() in ofApp::setup() ends the loop with the test result as the exit code
+    return ofRunApp(new ofApp(cycles, maxGrowthBytes));
+}
@@ -0,0 +1,50 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#include "ofApp.h"
+
+ofApp::ofApp(unsigned long long _cycles, size_t _maxGrowthBytes)
+{
+    cycles = _cycles;
+    maxGrowthBytes = _maxGrowthBytes;
+}
+
+void ofApp::setup()
+{
+    ofxLayerSoakTest soak(manager);
+    ofxLayerSoakReport report = soak.run(cycles);
+    
+    bool bRunaway = report.residentBytesEnd > report.residentBytesStart
+                    && report.residentBytesEnd - report.residentBytesStart > maxGrowthBytes;
+    if(report.bListenersLeaked)
+    {
+        ofLogError("soakTest") << report.layerListenersEnd << " listeners on " << report.liveLayersEnd << " live layers";
+    }
+    if(bRunaway)
+    {
+        ofLogError("soakTest") << "resident memory grew by " << (report.residentBytesEnd - report.residentBytesStart) / 1024
+                               << " KB, limit is " << maxGrowthBytes / 1024 << " KB";
+    }
+    ofExit(report.bListenersLeaked || bRunaway ? 1 : 0);
+}
@@ -0,0 +1,44 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxLayerManager.h"
+#include "ofxLayerSoakTest.h"
+
+//Runs the soak test once from setup() and exits with 0 if it passed, 1 if listeners leaked
+//or resident memory grew by more than maxGrowthBytes
+class ofApp : public ofBaseApp
+{
+public:
+    ofApp(unsigned long long _cycles, size_t _maxGrowthBytes);
+    
+    void setup();
+    
+private:
+    unsigned long long cycles;
+    size_t maxGrowthBytes;
+    ofxLayerManager manager;
+};
@@ -27,12 +27,45 @@
 
 #include "ofEvents.h"
 #include "ofMain.h"
+#include "ofxLayerDrawList.h"
+#include "ofxLayerDoubleBuffer.h"
+#include <atomic>
 
 using namespace std; 
 
 class ofxLayer; 
 class ofxLayerManager; 
 class ofxSharedAppData; 
+class ofxLayerAssetCache;
+
+//Input events a layer can declare interest in, the manager only dispatches an event type to layers whose mask has its bit
+enum ofxLayerEvent
+{
+    OFX_LAYER_EVENT_TOUCH_DOWN = 0,
+    OFX_LAYER_EVENT_TOUCH_MOVED,
+    OFX_LAYER_EVENT_TOUCH_UP,
+    OFX_LAYER_EVENT_TOUCH_DOUBLE_TAP,
+    OFX_LAYER_EVENT_TOUCH_CANCELLED,
+    OFX_LAYER_EVENT_MOUSE_RELEASED,
+    OFX_LAYER_EVENT_MOUSE_PRESSED,
+    OFX_LAYER_EVENT_MOUSE_MOVED,
+    OFX_LAYER_EVENT_MOUSE_DRAGGED,
+    OFX_LAYER_EVENT_KEY_PRESSED,
+    OFX_LAYER_EVENT_KEY_RELEASED,
+    OFX_LAYER_EVENT_KEY_DOWN,
+    OFX_LAYER_EVENT_KEY_UP,
+    OFX_LAYER_EVENT_MENU_PRESSED,
+    OFX_LAYER_EVENT_OK_PRESSED,
+    OFX_LAYER_EVENT_CANCEL_PRESSED,
+    OFX_LAYER_EVENT_BACK_PRESSED,
+    OFX_LAYER_EVENT_MENU_ITEM_SELECTED,
+    OFX_LAYER_EVENT_MENU_ITEM_CHECKED,
+    OFX_LAYER_EVENT_COUNT
+};
+
+#define OFX_LAYER_EVENT_BIT(event) (1u << (event))
+#define OFX_LAYER_EVENTS_NONE 0u
+#define OFX_LAYER_EVENTS_ALL 0xFFFFFFFFu
 
 class ofxLayerEventArgs : public ofEventArgs {
 public:
@@ -61,6 +94,19 @@ public:
 		active = false;
         bSetup = false;
         bDead = false; 
+        bIndependentExit = false;
+        bRetainedDraw = false;
+        bPipelined = false;
+        eventInterest = OFX_LAYER_EVENTS_ALL;
+        bExplicitInterest = false;
+        bDirty = true;
+        bChanged = true;
+        assetCache = NULL;
+        layoutWidth = -1;
+        layoutHeight = -1;
+#ifdef TARGET_OF_IPHONE
+        layoutOrientation = -1;
+#endif
 	}
 
 	virtual ~ofxLayer() 
@@ -72,7 +118,30 @@ public:
     virtual void draw() {}
     virtual void exit() {}
     
+    //Retained layers record their frame into a draw list instead of drawing it, the manager replays it.
+    //record() may run on a worker thread next to other layers' record(), so it must not make GL calls
+    //or change state other layers read.
+    virtual void record(ofxLayerDrawList &list) {}
+    
+    //Optional state for the manager's warm start snapshot. serialize() is asked when the layer is
+    //deactivated and at exit, deserialize() gets the last blob back after the layer is restored on boot.
+    //Both run on the main thread, for a pipelined layer never while its updateAsync() is running.
+    virtual bool serialize(string &blob) { return false; }
+    virtual void deserialize(const string &blob) {}
+    
+    //Pipelined layers get updateAsync() on a worker instead of update(), running while the main thread draws
+    //the previous frame. It may only touch the update side of the layer's state (see ofxLayerDoubleBuffer),
+    //publish() runs on the main thread once that update is done, before the next one starts, and makes it
+    //what draw() shows. Input handlers run on the main thread too and should queue for publish() to apply.
+    //markDirty() is the one call on the layer itself that is safe from here, an animating layer keeps making it.
+    virtual void updateAsync() {}
+    virtual void publish() {}
+    
     virtual string getLayerName() {return layerName;}
+    
+    //Bytes the layer holds on to, for the manager's lifecycle accounting. Layers add their own
+    //resources on top of what the base class keeps.
+    virtual size_t getMemoryUsage() { return drawList.getCapacityBytes(); }
 
     bool isActive() { return active; } 
     
@@ -149,32 +218,119 @@ public:
         return bDead; 
     }
     
+    //an independent layer's exit() and destructor touch nothing shared (no GL, no other layers),
+    //so the manager may tear it down on a worker thread
+    void setIndependentExit(bool _bIndependentExit)
+    {
+        bIndependentExit = _bIndependentExit;
+    }
+    
+    bool isIndependentExit()
+    {
+        return bIndependentExit;
+    }
+    
+    void setRetainedDraw(bool _bRetainedDraw)
+    {
+        bRetainedDraw = _bRetainedDraw;
+    }
+    
+    bool isRetainedDraw()
+    {
+        return bRetainedDraw;
+    }
+    
+    ofxLayerDrawList& getDrawList() { return drawList; }
+    
+    void setPipelined(bool _bPipelined)
+    {
+        bPipelined = _bPipelined;
+    }
+    
+    bool isPipelined()
+    {
+        return bPipelined;
+    }
+    
+    //Without an explicit mask a layer starts out interested in everything and drops an event type
+    //the first time the empty default handler below runs for it, so overrides shouldn't call them.
+    void setEventInterest(unsigned int mask)
+    {
+        eventInterest = mask;
+        bExplicitInterest = true;
+        notifyInterestChanged();
+    }
+    
+    unsigned int getEventInterest() { return eventInterest; }
+    
+    bool isInterestedIn(ofxLayerEvent event) { return (eventInterest & OFX_LAYER_EVENT_BIT(event)) != 0; }
+    
+    //A dirty layer has something new to show. Input the manager routes to a layer, activation and
+    //resizes mark it, the manager clears it right before calling update(). In idle mode a clean
+    //layer's update() is skipped, so a layer that animates keeps calling markDirty() from update().
+    //The flag is atomic, pipelined layers mark it from updateAsync() while the main thread dispatches input.
+    void markDirty() { bDirty = true; }
+    bool isDirty() { return bDirty; }
+    void clearDirty() { bDirty = false; }
+    
+    //whether the layer was dirty going into this frame's update
+    bool hasChanged() { return bChanged; }
+    
+    void setChanged(bool _bChanged)
+    {
+        bChanged = _bChanged;
+    }
+    
+    //size (and orientation) the layer last laid itself out for, -1 if unknown
+    int getLayoutWidth() { return layoutWidth; }
+    int getLayoutHeight() { return layoutHeight; }
+    
+    void setLayoutSize(int w, int h)
+    {
+        layoutWidth = w;
+        layoutHeight = h;
+    }
+    
+#ifdef TARGET_OF_IPHONE
+    int getLayoutOrientation() { return layoutOrientation; }
+    
+    void setLayoutOrientation(int orientation)
+    {
+        layoutOrientation = orientation;
+    }
+#endif
+    
     ofEvent<ofxLayerEventArgs> deleteLayerEvent;
     ofEvent<ofxLayerEventArgs> switchLayerEvent;
     ofEvent<ofxLayerEventArgs> activateLayerEvent;    
     ofEvent<ofxLayerEventArgs> deactivateLayerEvent;    
+    ofEvent<ofxLayerEventArgs> interestChangedEvent;
     
-    virtual void touchDown(ofTouchEventArgs& touch) {}
-    virtual void touchMoved(ofTouchEventArgs& touch) {}
-    virtual void touchUp(ofTouchEventArgs& touch) {}
-    virtual void touchDoubleTap(ofTouchEventArgs& touch) {}
-    virtual void touchCancelled(ofTouchEventArgs& touch) {}
+    virtual void touchDown(ofTouchEventArgs& touch) { ignoreEvent(OFX_LAYER_EVENT_TOUCH_DOWN); }
+    virtual void touchMoved(ofTouchEventArgs& touch) { ignoreEvent(OFX_LAYER_EVENT_TOUCH_MOVED); }
+    virtual void touchUp(ofTouchEventArgs& touch) { ignoreEvent(OFX_LAYER_EVENT_TOUCH_UP); }
+    virtual void touchDoubleTap(ofTouchEventArgs& touch) { ignoreEvent(OFX_LAYER_EVENT_TOUCH_DOUBLE_TAP); }
+    virtual void touchCancelled(ofTouchEventArgs& touch) { ignoreEvent(OFX_LAYER_EVENT_TOUCH_CANCELLED); }
     
 #ifndef TARGET_OPENGLES
     
-    virtual void mouseReleased(ofMouseEventArgs& data) {}
-    virtual void mousePressed(ofMouseEventArgs& data) {}
-    virtual void mouseMoved(ofMouseEventArgs& data) {}
-    virtual void mouseDragged(ofMouseEventArgs& data) {}
+    virtual void mouseReleased(ofMouseEventArgs& data) { ignoreEvent(OFX_LAYER_EVENT_MOUSE_RELEASED); }
+    virtual void mousePressed(ofMouseEventArgs& data) { ignoreEvent(OFX_LAYER_EVENT_MOUSE_PRESSED); }
+    virtual void mouseMoved(ofMouseEventArgs& data) { ignoreEvent(OFX_LAYER_EVENT_MOUSE_MOVED); }
+    virtual void mouseDragged(ofMouseEventArgs& data) { ignoreEvent(OFX_LAYER_EVENT_MOUSE_DRAGGED); }
     
-    virtual void keyPressed(int key) {}
-    virtual void keyReleased(int key) {}
+    virtual void keyPressed(int key) { ignoreEvent(OFX_LAYER_EVENT_KEY_PRESSED); }
+    virtual void keyReleased(int key) { ignoreEvent(OFX_LAYER_EVENT_KEY_RELEASED); }
     virtual void windowResized(int w, int h) {}
 
 #endif
     
     void setSharedAppData(ofxSharedAppData* sharedAppData) { this->sharedAppData = sharedAppData; }
     
+    //the manager's shared asset cache, include ofxLayerAssetCache.h to acquire from it
+    void setAssetCache(ofxLayerAssetCache* assetCache) { this->assetCache = assetCache; }
+    ofxLayerAssetCache* getAssetCache() { return assetCache; }
+    
 #ifdef TARGET_ANDROID
     virtual void savePressed(string title, string tags){};
     virtual void imageSelected(string imageURL){};
@@ -183,17 +339,17 @@ public:
 	virtual void resume(){};
 	virtual void reloadTextures(){}
 
-    virtual void onKeyDown(int keyCode){}    
-	virtual void onKeyUp(int keyCode){}
+    virtual void onKeyDown(int keyCode){ ignoreEvent(OFX_LAYER_EVENT_KEY_DOWN); }
+	virtual void onKeyUp(int keyCode){ ignoreEvent(OFX_LAYER_EVENT_KEY_UP); }
     
-	virtual bool backPressed(){ return false; }
-	virtual void menuPressed(){}
+	virtual bool backPressed(){ ignoreEvent(OFX_LAYER_EVENT_BACK_PRESSED); return false; }
+	virtual void menuPressed(){ ignoreEvent(OFX_LAYER_EVENT_MENU_PRESSED); }
     
-	virtual bool menuItemSelected(string menu_id_str){ return false; }    
-	virtual bool menuItemChecked(string menu_id_str, bool checked){ return false; }
+	virtual bool menuItemSelected(string menu_id_str){ ignoreEvent(OFX_LAYER_EVENT_MENU_ITEM_SELECTED); return false; }    
+	virtual bool menuItemChecked(string menu_id_str, bool checked){ ignoreEvent(OFX_LAYER_EVENT_MENU_ITEM_CHECKED); return false; }
     
-	virtual void okPressed(){};
-	virtual void cancelPressed(){};
+	virtual void okPressed(){ ignoreEvent(OFX_LAYER_EVENT_OK_PRESSED); }
+	virtual void cancelPressed(){ ignoreEvent(OFX_LAYER_EVENT_CANCEL_PRESSED); }
 	virtual void gotFile(string url, string filename){};
 	virtual void urlResponse(ofHttpResponse & response) {};
     
@@ -209,12 +365,41 @@ public:
 #endif
     
 protected:
+    void ignoreEvent(ofxLayerEvent event)
+    {
+        if(!bExplicitInterest && isInterestedIn(event))
+        {
+            eventInterest &= ~OFX_LAYER_EVENT_BIT(event);
+            notifyInterestChanged();
+        }
+    }
+    
+    void notifyInterestChanged()
+    {
+        ofxLayerEventArgs args = ofxLayerEventArgs(layerName, this);
+        ofNotifyEvent(interestChangedEvent, args, this);
+    }
+    
     ofxLayerManager *manager;
     ofxSharedAppData* sharedAppData;
+    ofxLayerAssetCache* assetCache;
 	string layerName; 
     bool active;    //means that the layer should be updating and drawing
     bool bSetup;
     bool bDead;
+    bool bIndependentExit;
+    bool bRetainedDraw;
+    bool bPipelined;
+    ofxLayerDrawList drawList;
+    unsigned int eventInterest;
+    bool bExplicitInterest;
+    std::atomic<bool> bDirty;
+    bool bChanged;
+    int layoutWidth;
+    int layoutHeight;
+#ifdef TARGET_OF_IPHONE
+    int layoutOrientation;
+#endif
 };
 
 #endif
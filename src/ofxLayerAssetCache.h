@@ -0,0 +1,391 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#ifndef OFXLAYERASSETCACHE
+#define OFXLAYERASSETCACHE
+
+#include "ofMain.h"
+#include "ofxLayerWorkerPool.h"
+#include <memory>
+#include <atomic>
+#include <typeinfo>
+#include <list>
+#include <map>
+
+class ofxLayerAssetCache;
+
+enum ofxLayerAssetState
+{
+    OFX_LAYER_ASSET_LOADING = 0,
+    OFX_LAYER_ASSET_READY,
+    OFX_LAYER_ASSET_FAILED
+};
+
+struct ofxLayerAssetEntry
+{
+    string name;
+    const std::type_info *type;
+    std::shared_ptr<void> value;
+    size_t bytes;
+    int refs;
+    std::atomic<int> state;
+    bool bInLru;
+    std::list<ofxLayerAssetEntry*>::iterator lru;
+};
+
+struct ofxLayerAssetStats
+{
+    ofxLayerAssetStats()
+    {
+        hits = 0;
+        misses = 0;
+        evictions = 0;
+        bytes = 0;
+        byteBudget = 0;
+        entries = 0;
+        loading = 0;
+    }
+    
+    unsigned long long hits;        //acquires served by an entry that was loaded or already loading
+    unsigned long long misses;      //acquires that started a load
+    unsigned long long evictions;
+    size_t bytes;                   //decoded bytes held, referenced or not
+    size_t byteBudget;
+    size_t entries;
+    size_t loading;
+};
+
+//Counted reference to a cached asset. Copies share the reference, the asset becomes evictable
+//once the last one is gone. get() is NULL until the load finished (or if it failed).
+template<class T>
+class ofxLayerAsset
+{
+public:
+    ofxLayerAsset()
+    {
+        cache = NULL;
+    }
+    
+    ofxLayerAsset(ofxLayerAssetCache *_cache, std::shared_ptr<ofxLayerAssetEntry> _entry)
+    {
+        cache = _cache;
+        entry = _entry;
+    }
+    
+    ofxLayerAsset(const ofxLayerAsset &other);
+    ofxLayerAsset& operator=(const ofxLayerAsset &other);
+    ~ofxLayerAsset();
+    
+    void release();
+    //blocks until the load is done. Not from a job on one of the manager's worker pools (parallel record() or
+    //exit(), updateAsync()), the load may be queued behind it, only from the main thread or a thread of your own.
+    void wait();
+    
+    bool isValid() const { return entry != NULL; }
+    bool isReady() const { return entry != NULL && entry->state.load() == OFX_LAYER_ASSET_READY; }
+    bool isFailed() const { return entry != NULL && entry->state.load() == OFX_LAYER_ASSET_FAILED; }
+    string getName() const { return entry != NULL ? entry->name : ""; }
+    
+    T* get() const
+    {
+        return isReady() ? static_cast<T*>(entry->value.get()) : NULL;
+    }
+    
+    T* operator->() const { return get(); }
+    
+private:
+    ofxLayerAssetCache *cache;
+    std::shared_ptr<ofxLayerAssetEntry> entry;
+};
+
+//Name keyed, reference counted cache the layers of one manager share, so screens using the same
+//images or data files decode them once. Loads run on the manager's load pool, a second acquire of a name
+//that is still loading waits on the same load. Entries nobody references stay around until the
+//decoded bytes go over the budget, then the least recently released ones go first.
+//Only CPU side data is cached here: anything that needs the GL context (textures, fonts) is
+//created by the layer on the main thread from what the cache hands back.
+class ofxLayerAssetCache
+{
+public:
+    ofxLayerAssetCache()
+    {
+        bytes = 0;
+        byteBudget = 256 * 1024 * 1024;
+    }
+    
+    ~ofxLayerAssetCache()
+    {
+        loads.wait();
+    }
+    
+    //where loads run, a pool nothing else queues on. Without one they run synchronously inside acquire
+    void setWorkerPool(std::function<ofxLayerWorkerPool&()> _workerPool) { workerPool = _workerPool; }
+    
+    void setByteBudget(size_t _byteBudget)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        byteBudget = _byteBudget;
+        evictLocked();
+    }
+    
+    size_t getByteBudget() { return byteBudget; }
+    
+    //loader fills in a default constructed T and returns false on failure, it runs on a worker thread
+    template<class T>
+    ofxLayerAsset<T> acquire(const string &name, std::function<bool(T&)> loader, std::function<size_t(const T&)> sizeOf)
+    {
+        std::shared_ptr<ofxLayerAssetEntry> entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::map<string, std::shared_ptr<ofxLayerAssetEntry> >::iterator it = entries.find(name);
+            if(it != entries.end())
+            {
+                if(*it->second->type != typeid(T))
+                {
+                    ofLogError("ofxLayerAssetCache") << name << " is cached as a different type";
+                    return ofxLayerAsset<T>();
+                }
+                stats.hits++;
+                retainLocked(it->second.get());
+                return ofxLayerAsset<T>(this, it->second);
+            }
+            stats.misses++;
+            entry = std::make_shared<ofxLayerAssetEntry>();
+            entry->name = name;
+            entry->type = &typeid(T);
+            entry->bytes = 0;
+            entry->refs = 1;
+            entry->state.store(OFX_LAYER_ASSET_LOADING);
+            entry->bInLru = false;
+            entries[name] = entry;
+        }
+        
+        std::function<void()> job = [this, entry, loader, sizeOf]()
+        {
+            std::shared_ptr<T> value = std::make_shared<T>();
+            bool bLoaded = loader(*value);
+            finishLoad(entry, bLoaded ? std::static_pointer_cast<void>(value) : std::shared_ptr<void>(), bLoaded ? sizeOf(*value) : 0);
+        };
+        if(workerPool)
+        {
+            workerPool().run(loads, job);
+        }
+        else
+        {
+            job();
+        }
+        return ofxLayerAsset<T>(this, entry);
+    }
+    
+    ofxLayerAsset<ofPixels> acquirePixels(const string &path)
+    {
+        return acquire<ofPixels>(path, [path](ofPixels &pixels) { return ofLoadImage(pixels, path); },
+                                 [](const ofPixels &pixels) { return (size_t) pixels.getTotalBytes(); });
+    }
+    
+    ofxLayerAsset<ofBuffer> acquireBuffer(const string &path)
+    {
+        return acquire<ofBuffer>(path, [path](ofBuffer &buffer) { buffer = ofBufferFromFile(path, true); return buffer.size() > 0; },
+                                 [](const ofBuffer &buffer) { return (size_t) buffer.size(); });
+    }
+    
+    ofxLayerAssetStats getStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ofxLayerAssetStats current = stats;
+        current.bytes = bytes;
+        current.byteBudget = byteBudget;
+        current.entries = entries.size();
+        current.loading = 0;
+        for(std::map<string, std::shared_ptr<ofxLayerAssetEntry> >::iterator it = entries.begin(); it != entries.end(); ++it)
+        {
+            if(it->second->state.load() == OFX_LAYER_ASSET_LOADING) { current.loading++; }
+        }
+        return current;
+    }
+    
+    //drops every entry nobody references
+    void purge()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t budget = byteBudget;
+        byteBudget = 0;
+        evictLocked();
+        byteBudget = budget;
+    }
+    
+private:
+    template<class T> friend class ofxLayerAsset;
+    
+    void retain(ofxLayerAssetEntry *entry)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        retainLocked(entry);
+    }
+    
+    void retainLocked(ofxLayerAssetEntry *entry)
+    {
+        if(entry->bInLru)
+        {
+            lru.erase(entry->lru);
+            entry->bInLru = false;
+        }
+        entry->refs++;
+    }
+    
+    void release(ofxLayerAssetEntry *entry)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entry->refs--;
+        unreferencedLocked(entry);
+    }
+    
+    void unreferencedLocked(ofxLayerAssetEntry *entry)
+    {
+        if(entry->refs > 0 || entry->state.load() == OFX_LAYER_ASSET_LOADING)
+        {
+            return;
+        }
+        if(entry->state.load() == OFX_LAYER_ASSET_FAILED)
+        {
+            //failures aren't cached, the next acquire tries again
+            string name = entry->name;
+            entries.erase(name);
+            return;
+        }
+        lru.push_front(entry);
+        entry->lru = lru.begin();
+        entry->bInLru = true;
+        evictLocked();
+    }
+    
+    void wait(ofxLayerAssetEntry *entry)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(entry->state.load() == OFX_LAYER_ASSET_LOADING)
+        {
+            loaded.wait(lock);
+        }
+    }
+    
+    void finishLoad(std::shared_ptr<ofxLayerAssetEntry> entry, std::shared_ptr<void> value, size_t valueBytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entry->value = value;
+        entry->bytes = valueBytes;
+        bytes += valueBytes;
+        entry->state.store(value != NULL ? OFX_LAYER_ASSET_READY : OFX_LAYER_ASSET_FAILED);
+        if(value == NULL)
+        {
+            ofLogError("ofxLayerAssetCache") << "couldn't load " << entry->name;
+        }
+        loaded.notify_all();
+        unreferencedLocked(entry.get());
+        if(value != NULL)
+        {
+            evictLocked();
+        }
+    }
+    
+    void evictLocked()
+    {
+        while(bytes > byteBudget && !lru.empty())
+        {
+            ofxLayerAssetEntry *victim = lru.back();
+            lru.pop_back();
+            victim->bInLru = false;
+            bytes -= victim->bytes;
+            stats.evictions++;
+            string name = victim->name;
+            entries.erase(name);
+        }
+    }
+    
+    ofxLayerAssetCache(const ofxLayerAssetCache&);
+    ofxLayerAssetCache& operator=(const ofxLayerAssetCache&);
+    
+    std::mutex mutex;
+    std::condition_variable loaded;
+    std::map<string, std::shared_ptr<ofxLayerAssetEntry> > entries;
+    std::list<ofxLayerAssetEntry*> lru;     //unreferenced entries, most recently released first
+    size_t bytes;
+    size_t byteBudget;
+    ofxLayerAssetStats stats;
+    std::function<ofxLayerWorkerPool&()> workerPool;
+    ofxLayerTaskGroup loads;
+};
+
+template<class T>
+ofxLayerAsset<T>::ofxLayerAsset(const ofxLayerAsset &other)
+{
+    cache = other.cache;
+    entry = other.entry;
+    if(entry != NULL)
+    {
+        cache->retain(entry.get());
+    }
+}
+
+template<class T>
+ofxLayerAsset<T>& ofxLayerAsset<T>::operator=(const ofxLayerAsset &other)
+{
+    if(entry != other.entry)
+    {
+        if(other.entry != NULL)
+        {
+            other.cache->retain(other.entry.get());
+        }
+        release();
+        cache = other.cache;
+        entry = other.entry;
+    }
+    return *this;
+}
+
+template<class T>
+ofxLayerAsset<T>::~ofxLayerAsset()
+{
+    release();
+}
+
+template<class T>
+void ofxLayerAsset<T>::release()
+{
+    if(entry != NULL)
+    {
+        cache->release(entry.get());
+        entry.reset();
+    }
+}
+
+template<class T>
+void ofxLayerAsset<T>::wait()
+{
+    if(entry != NULL)
+    {
+        cache->wait(entry.get());
+    }
+}
+
+#endif
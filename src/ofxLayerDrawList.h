@@ -0,0 +1,284 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#ifndef OFXLAYERDRAWLIST
+#define OFXLAYERDRAWLIST
+
+#include "ofMain.h"
+#include <vector>
+
+enum ofxLayerDrawCommandType
+{
+    OFX_LAYER_DRAW_PUSH_MATRIX = 0,
+    OFX_LAYER_DRAW_POP_MATRIX,
+    OFX_LAYER_DRAW_TRANSLATE,
+    OFX_LAYER_DRAW_ROTATE,
+    OFX_LAYER_DRAW_SCALE,
+    OFX_LAYER_DRAW_COLOR,
+    OFX_LAYER_DRAW_FILL,
+    OFX_LAYER_DRAW_NO_FILL,
+    OFX_LAYER_DRAW_LINE_WIDTH,
+    OFX_LAYER_DRAW_RECTANGLE,
+    OFX_LAYER_DRAW_CIRCLE,
+    OFX_LAYER_DRAW_ELLIPSE,
+    OFX_LAYER_DRAW_LINE,
+    OFX_LAYER_DRAW_TEXT,
+    OFX_LAYER_DRAW_IMAGE,
+    OFX_LAYER_DRAW_COMMAND_COUNT
+};
+
+struct ofxLayerDrawCommand
+{
+    ofxLayerDrawCommandType type;
+    float v[4];
+    size_t textOffset;              //into the list's text arena
+    size_t textLength;
+    const ofBaseDraws *image;       //not owned, has to outlive the replay
+};
+
+//Where a recorded list ends up. The GL backend issues the matching oF calls,
+//the null backend only counts so lists can be recorded and checked without a window.
+class ofxLayerDrawBackend
+{
+public:
+    virtual ~ofxLayerDrawBackend() {}
+    
+    virtual void pushMatrix() = 0;
+    virtual void popMatrix() = 0;
+    virtual void translate(float x, float y, float z) = 0;
+    virtual void rotate(float degrees, float x, float y, float z) = 0;
+    virtual void scale(float x, float y, float z) = 0;
+    virtual void setColor(float r, float g, float b, float a) = 0;
+    virtual void fill() = 0;
+    virtual void noFill() = 0;
+    virtual void setLineWidth(float width) = 0;
+    virtual void drawRectangle(float x, float y, float w, float h) = 0;
+    virtual void drawCircle(float x, float y, float radius) = 0;
+    virtual void drawEllipse(float x, float y, float w, float h) = 0;
+    virtual void drawLine(float x1, float y1, float x2, float y2) = 0;
+    virtual void drawText(const char *text, size_t length, float x, float y) = 0;
+    virtual void drawImage(const ofBaseDraws &image, float x, float y, float w, float h) = 0;
+};
+
+class ofxLayerGLDrawBackend : public ofxLayerDrawBackend
+{
+public:
+    void pushMatrix() { ofPushMatrix(); }
+    void popMatrix() { ofPopMatrix(); }
+    void translate(float x, float y, float z) { ofTranslate(x, y, z); }
+    void rotate(float degrees, float x, float y, float z)
+    {
+#if OF_VERSION_MAJOR == 0 && OF_VERSION_MINOR < 10
+        ofRotate(degrees, x, y, z);
+#else
+        ofRotateDeg(degrees, x, y, z);
+#endif
+    }
+    void scale(float x, float y, float z) { ofScale(x, y, z); }
+    void setColor(float r, float g, float b, float a) { ofSetColor(r, g, b, a); }
+    void fill() { ofFill(); }
+    void noFill() { ofNoFill(); }
+    void setLineWidth(float width) { ofSetLineWidth(width); }
+    void drawRectangle(float x, float y, float w, float h) { ofDrawRectangle(x, y, w, h); }
+    void drawCircle(float x, float y, float radius) { ofDrawCircle(x, y, radius); }
+    void drawEllipse(float x, float y, float w, float h) { ofDrawEllipse(x, y, w, h); }
+    void drawLine(float x1, float y1, float x2, float y2) { ofDrawLine(x1, y1, x2, y2); }
+    void drawText(const char *text, size_t length, float x, float y) { ofDrawBitmapString(string(text, length), x, y); }
+    void drawImage(const ofBaseDraws &image, float x, float y, float w, float h) { image.draw(x, y, w, h); }
+};
+
+class ofxLayerNullDrawBackend : public ofxLayerDrawBackend
+{
+public:
+    ofxLayerNullDrawBackend()
+    {
+        reset();
+    }
+    
+    void reset()
+    {
+        for(int i = 0; i < OFX_LAYER_DRAW_COMMAND_COUNT; i++)
+        {
+            counts[i] = 0;
+        }
+        matrixDepth = 0;
+        maxMatrixDepth = 0;
+        textBytes = 0;
+    }
+    
+    size_t getCount(ofxLayerDrawCommandType type) { return counts[type]; }
+    
+    size_t getTotalCount()
+    {
+        size_t total = 0;
+        for(int i = 0; i < OFX_LAYER_DRAW_COMMAND_COUNT; i++)
+        {
+            total += counts[i];
+        }
+        return total;
+    }
+    
+    //non zero after a replay means unbalanced push/pop
+    int getMatrixDepth() { return matrixDepth; }
+    int getMaxMatrixDepth() { return maxMatrixDepth; }
+    size_t getTextBytes() { return textBytes; }
+    
+    void pushMatrix()
+    {
+        counts[OFX_LAYER_DRAW_PUSH_MATRIX]++;
+        matrixDepth++;
+        maxMatrixDepth = MAX(maxMatrixDepth, matrixDepth);
+    }
+    void popMatrix()
+    {
+        counts[OFX_LAYER_DRAW_POP_MATRIX]++;
+        matrixDepth--;
+    }
+    void translate(float x, float y, float z) { counts[OFX_LAYER_DRAW_TRANSLATE]++; }
+    void rotate(float degrees, float x, float y, float z) { counts[OFX_LAYER_DRAW_ROTATE]++; }
+    void scale(float x, float y, float z) { counts[OFX_LAYER_DRAW_SCALE]++; }
+    void setColor(float r, float g, float b, float a) { counts[OFX_LAYER_DRAW_COLOR]++; }
+    void fill() { counts[OFX_LAYER_DRAW_FILL]++; }
+    void noFill() { counts[OFX_LAYER_DRAW_NO_FILL]++; }
+    void setLineWidth(float width) { counts[OFX_LAYER_DRAW_LINE_WIDTH]++; }
+    void drawRectangle(float x, float y, float w, float h) { counts[OFX_LAYER_DRAW_RECTANGLE]++; }
+    void drawCircle(float x, float y, float radius) { counts[OFX_LAYER_DRAW_CIRCLE]++; }
+    void drawEllipse(float x, float y, float w, float h) { counts[OFX_LAYER_DRAW_ELLIPSE]++; }
+    void drawLine(float x1, float y1, float x2, float y2) { counts[OFX_LAYER_DRAW_LINE]++; }
+    void drawText(const char *text, size_t length, float x, float y)
+    {
+        counts[OFX_LAYER_DRAW_TEXT]++;
+        textBytes += length;
+    }
+    void drawImage(const ofBaseDraws &image, float x, float y, float w, float h) { counts[OFX_LAYER_DRAW_IMAGE]++; }
+    
+private:
+    size_t counts[OFX_LAYER_DRAW_COMMAND_COUNT];
+    int matrixDepth;
+    int maxMatrixDepth;
+    size_t textBytes;
+};
+
+//CPU side command list a retained layer records into, possibly on a worker thread.
+//clear() keeps the storage around so a layer recording a similar frame every time stops allocating.
+class ofxLayerDrawList
+{
+public:
+    void clear()
+    {
+        commands.clear();
+        text.clear();
+    }
+    
+    bool empty() { return commands.empty(); }
+    size_t size() { return commands.size(); }
+    
+    //bytes currently reserved by the list's arena
+    size_t getCapacityBytes()
+    {
+        return commands.capacity() * sizeof(ofxLayerDrawCommand) + text.capacity();
+    }
+    
+    void pushMatrix() { add(OFX_LAYER_DRAW_PUSH_MATRIX); }
+    void popMatrix() { add(OFX_LAYER_DRAW_POP_MATRIX); }
+    void translate(float x, float y, float z = 0) { add(OFX_LAYER_DRAW_TRANSLATE, x, y, z); }
+    void rotate(float degrees, float x = 0, float y = 0, float z = 1) { add(OFX_LAYER_DRAW_ROTATE, degrees, x, y, z); }
+    void scale(float x, float y, float z = 1) { add(OFX_LAYER_DRAW_SCALE, x, y, z); }
+    void setColor(float r, float g, float b, float a = 255) { add(OFX_LAYER_DRAW_COLOR, r, g, b, a); }
+    void setColor(float gray) { add(OFX_LAYER_DRAW_COLOR, gray, gray, gray, 255); }
+    void fill() { add(OFX_LAYER_DRAW_FILL); }
+    void noFill() { add(OFX_LAYER_DRAW_NO_FILL); }
+    void setLineWidth(float width) { add(OFX_LAYER_DRAW_LINE_WIDTH, width); }
+    void drawRectangle(float x, float y, float w, float h) { add(OFX_LAYER_DRAW_RECTANGLE, x, y, w, h); }
+    void drawCircle(float x, float y, float radius) { add(OFX_LAYER_DRAW_CIRCLE, x, y, radius); }
+    void drawEllipse(float x, float y, float w, float h) { add(OFX_LAYER_DRAW_ELLIPSE, x, y, w, h); }
+    void drawLine(float x1, float y1, float x2, float y2) { add(OFX_LAYER_DRAW_LINE, x1, y1, x2, y2); }
+    
+    void drawBitmapString(const string &s, float x, float y)
+    {
+        ofxLayerDrawCommand &c = add(OFX_LAYER_DRAW_TEXT, x, y);
+        c.textOffset = text.size();
+        c.textLength = s.size();
+        text.insert(text.end(), s.begin(), s.end());
+    }
+    
+    void draw(const ofBaseDraws &image, float x, float y)
+    {
+        draw(image, x, y, image.getWidth(), image.getHeight());
+    }
+    
+    void draw(const ofBaseDraws &image, float x, float y, float w, float h)
+    {
+        ofxLayerDrawCommand &c = add(OFX_LAYER_DRAW_IMAGE, x, y, w, h);
+        c.image = &image;
+    }
+    
+    void replay(ofxLayerDrawBackend &backend)
+    {
+        for(size_t i = 0; i < commands.size(); i++)
+        {
+            const ofxLayerDrawCommand &c = commands[i];
+            switch(c.type)
+            {
+                case OFX_LAYER_DRAW_PUSH_MATRIX: backend.pushMatrix(); break;
+                case OFX_LAYER_DRAW_POP_MATRIX: backend.popMatrix(); break;
+                case OFX_LAYER_DRAW_TRANSLATE: backend.translate(c.v[0], c.v[1], c.v[2]); break;
+                case OFX_LAYER_DRAW_ROTATE: backend.rotate(c.v[0], c.v[1], c.v[2], c.v[3]); break;
+                case OFX_LAYER_DRAW_SCALE: backend.scale(c.v[0], c.v[1], c.v[2]); break;
+                case OFX_LAYER_DRAW_COLOR: backend.setColor(c.v[0], c.v[1], c.v[2], c.v[3]); break;
+                case OFX_LAYER_DRAW_FILL: backend.fill(); break;
+                case OFX_LAYER_DRAW_NO_FILL: backend.noFill(); break;
+                case OFX_LAYER_DRAW_LINE_WIDTH: backend.setLineWidth(c.v[0]); break;
+                case OFX_LAYER_DRAW_RECTANGLE: backend.drawRectangle(c.v[0], c.v[1], c.v[2], c.v[3]); break;
+                case OFX_LAYER_DRAW_CIRCLE: backend.drawCircle(c.v[0], c.v[1], c.v[2]); break;
+                case OFX_LAYER_DRAW_ELLIPSE: backend.drawEllipse(c.v[0], c.v[1], c.v[2], c.v[3]); break;
+                case OFX_LAYER_DRAW_LINE: backend.drawLine(c.v[0], c.v[1], c.v[2], c.v[3]); break;
+                case OFX_LAYER_DRAW_TEXT: backend.drawText(text.data() + c.textOffset, c.textLength, c.v[0], c.v[1]); break;
+                case OFX_LAYER_DRAW_IMAGE: backend.drawImage(*c.image, c.v[0], c.v[1], c.v[2], c.v[3]); break;
+                default: break;
+            }
+        }
+    }
+    
+private:
+    ofxLayerDrawCommand& add(ofxLayerDrawCommandType type, float a = 0, float b = 0, float c = 0, float d = 0)
+    {
+        commands.push_back(ofxLayerDrawCommand());
+        ofxLayerDrawCommand &cmd = commands.back();
+        cmd.type = type;
+        cmd.v[0] = a;
+        cmd.v[1] = b;
+        cmd.v[2] = c;
+        cmd.v[3] = d;
+        cmd.textOffset = 0;
+        cmd.textLength = 0;
+        cmd.image = NULL;
+        return cmd;
+    }
+    
+    vector<ofxLayerDrawCommand> commands;
+    vector<char> text;
+};
+
+#endif
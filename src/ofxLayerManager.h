@@ -26,7 +26,68 @@
 #define OFXLAYERMANAGER
 
 #include "ofxLayer.h"
+#include "ofxLayerWorkerPool.h"
+#include "ofxLayerTable.h"
+#include "ofxLayerSnapshot.h"
+#include "ofxLayerAssetCache.h"
 #include <map>
+#include <chrono>
+#include <algorithm>
+
+//Counters of the work idle mode skipped, see ofxLayerManager::setIdleMode
+struct ofxLayerIdleStats
+{
+    ofxLayerIdleStats()
+    {
+        frames = 0;
+        idleFrames = 0;
+        updatesRun = 0;
+        updatesSkipped = 0;
+        drawsRun = 0;
+        drawsSkipped = 0;
+    }
+    
+    unsigned long long frames;
+    unsigned long long idleFrames;      //frames not drawn at all
+    unsigned long long updatesRun;
+    unsigned long long updatesSkipped;
+    unsigned long long drawsRun;
+    unsigned long long drawsSkipped;
+};
+
+#define OFX_LAYER_LISTENERS_PER_LAYER 5
+
+struct ofxLayerLifecycleStats
+{
+    ofxLayerLifecycleStats()
+    {
+        liveLayers = 0;
+        setupLayers = 0;
+        activeLayers = 0;
+        layerListeners = 0;
+        layerBytes = 0;
+        layersAdded = 0;
+        layersReplaced = 0;
+        layersDeleted = 0;
+    }
+    
+    size_t liveLayers;
+    size_t setupLayers;
+    size_t activeLayers;
+    size_t layerListeners;      //listeners registered on the live and retired layers' events, 5 per live layer when nothing leaks
+    size_t layerBytes;          //sum of the live layers' getMemoryUsage()
+    map<string, size_t> layerBytesByName;
+    unsigned long long layersAdded;
+    unsigned long long layersReplaced;
+    unsigned long long layersDeleted;
+};
+
+struct ofxLayerExitTiming
+{
+    string layerName;
+    double milliseconds;
+    bool bParallel;
+};
 
 class ofxLayerManager
 {
@@ -36,6 +97,33 @@ public:
     
 	ofxLayerManager()
     {
+        windowWidth = -1;
+        windowHeight = -1;
+        bResizePending = false;
+        bParallelExit = false;
+        bFastExit = false;
+        workerPool = NULL;
+        numWorkerThreads = 0;
+        pipelinePool = NULL;
+        numPipelineThreads = 0;
+        loadPool = NULL;
+        numLoadThreads = 0;
+        bParallelRecording = false;
+        drawBackend = &glDrawBackend;
+        bDispatchDirty = true;
+        bIdleMode = false;
+        bSleeping = false;
+        bVisibleChange = true;
+        bLayersChanged = false;
+        cleanFrames = 0;
+        idleDelayFrames = 30;
+        idleFrameRate = 5;
+        activeFrameRate = 60;
+        assetCache.setWorkerPool(std::bind(&ofxLayerManager::getLoadPool, this));
+#ifdef TARGET_OF_IPHONE
+        deviceOrientation = -1;
+        bOrientationPending = false;
+#endif
         enableAppEventCallbacks();
 #ifdef TARGET_OPENGLES
         enableTouchCallbacks();
@@ -49,6 +137,10 @@ public:
 	~ofxLayerManager()
 	{
         //exit function handles the dynamic memory...gets called by openframeworks before quiting
+        waitForPipeline();
+        delete pipelinePool;
+        delete loadPool;
+        delete workerPool;
 	}
     
     void enable()
@@ -69,14 +161,134 @@ public:
 
     void addLayer(ofxLayer* newlayer)
     {
+        layerIt it = layers.find(newlayer->getLayerName());
+        if (it != layers.end())
+        {
+            if(it->second == newlayer)
+            {
+                return;
+            }
+            //a layer with the same name gets replaced, not leaked with its listeners still attached
+            ofLogVerbose("ofxLayerManager") << "replacing layer " << it->first;
+            ofxLayer *old = it->second;
+            layers.erase(it);
+            retireLayer(old);
+            lifecycleStats.layersReplaced++;
+        }
         newlayer->setManager(this); 
         newlayer->setSharedAppData(sharedAppData);
+        newlayer->setAssetCache(&assetCache);
 //        newlayer->setup();
         layers[newlayer->getLayerName()] = newlayer;
         ofAddListener(newlayer->switchLayerEvent, this, &ofxLayerManager::onSwitchLayer);
         ofAddListener(newlayer->activateLayerEvent, this, &ofxLayerManager::onActivateLayer);
         ofAddListener(newlayer->deactivateLayerEvent, this, &ofxLayerManager::onDeactivateLayer);
         ofAddListener(newlayer->deleteLayerEvent, this, &ofxLayerManager::onDeleteLayer);        
+        ofAddListener(newlayer->interestChangedEvent, this, &ofxLayerManager::onInterestChanged);
+        lifecycleStats.layersAdded++;
+        bDispatchDirty = true;
+        refreshLayerTable();
+    }
+    
+    void removeLayerListeners(ofxLayer *l)
+    {
+        ofRemoveListener(l->switchLayerEvent, this, &ofxLayerManager::onSwitchLayer);
+        ofRemoveListener(l->activateLayerEvent, this, &ofxLayerManager::onActivateLayer);
+        ofRemoveListener(l->deactivateLayerEvent, this, &ofxLayerManager::onDeactivateLayer);
+        ofRemoveListener(l->deleteLayerEvent, this, &ofxLayerManager::onDeleteLayer);
+        ofRemoveListener(l->interestChangedEvent, this, &ofxLayerManager::onInterestChanged);
+    }
+    
+    //Takes a layer that is already out of the map out of dispatch and focus right away. Its exit() and delete
+    //wait for the sweep at the top of the next update(), the caller may be a loop still holding it or the layer itself.
+    void retireLayer(ofxLayer *l)
+    {
+        unfocusLayer(l);
+        removeLayerListeners(l);
+        l->setDead(true);
+        retiredLayers.push_back(l);
+        bDispatchDirty = true;
+    }
+    
+    //Tears down the retired layers and the ones that flagged themselves dead, called with no pipelined updates in flight
+    void sweepDeadLayers()
+    {
+        for (layerIt it = layers.begin(); it != layers.end(); )
+        {
+            ofxLayer *l = it->second;
+            if(l->isDead())
+            {
+                layers.erase(it++);
+                retireLayer(l);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        destroyRetiredLayers();
+    }
+    
+    void destroyRetiredLayers()
+    {
+        //a dying layer's exit() may replace further layers
+        while(!retiredLayers.empty())
+        {
+            vector<ofxLayer*> dying;
+            dying.swap(retiredLayers);
+            for (size_t i = 0; i < dying.size(); i++)
+            {
+                destroyLayer(dying[i]);
+            }
+        }
+    }
+    
+    void destroyLayer(ofxLayer *l)
+    {
+        if(l->isSetup())
+        {
+            if(l->isActive())
+            {
+                l->deactivate();
+            }
+            l->exit();
+        }
+        delete l;
+        lifecycleStats.layersDeleted++;
+        bDispatchDirty = true;
+    }
+    
+    //Live layers, listeners and memory as of now, plus add/replace/delete totals
+    ofxLayerLifecycleStats getLifecycleStats()
+    {
+        ofxLayerLifecycleStats current = lifecycleStats;
+        current.liveLayers = layers.size();
+        current.setupLayers = 0;
+        current.activeLayers = 0;
+        current.layerListeners = 0;
+        current.layerBytes = 0;
+        for (layerIt it = layers.begin(); it != layers.end(); ++it)
+        {
+            if(it->second->isSetup()) { current.setupLayers++; }
+            if(it->second->isActive()) { current.activeLayers++; }
+            current.layerListeners += countLayerListeners(it->second);
+            size_t bytes = it->second->getMemoryUsage();
+            current.layerBytes += bytes;
+            current.layerBytesByName[it->first] = bytes;
+        }
+        //retired layers should have none left
+        for (size_t i = 0; i < retiredLayers.size(); i++)
+        {
+            current.layerListeners += countLayerListeners(retiredLayers[i]);
+        }
+        return current;
+    }
+    
+    //what is actually registered on the layer's events, the manager's own OFX_LAYER_LISTENERS_PER_LAYER plus any others
+    static size_t countLayerListeners(ofxLayer *l)
+    {
+        return l->switchLayerEvent.size() + l->activateLayerEvent.size() + l->deactivateLayerEvent.size()
+             + l->deleteLayerEvent.size() + l->interestChangedEvent.size();
     }
     
     void onActivateLayer(ofxLayerEventArgs &args)
@@ -85,15 +297,125 @@ public:
         if (it != layers.end())
         {
         	ofxLayer *l = (ofxLayer *) it->second;
-            if(!l->isSetup())
+            setupAndActivate(l);
+        }
+    }
+
+    void onInterestChanged(ofxLayerEventArgs &args)
+    {
+        //only flag it, this usually fires from inside a dispatch loop
+        bDispatchDirty = true;
+    }
+    
+    //Layers interested in an event type, in map order. Rebuilt lazily before dispatching
+    //after a layer was added, removed or changed its interest mask.
+    vector<ofxLayer*>& getDispatchList(ofxLayerEvent event)
+    {
+        if(bDispatchDirty)
+        {
+            for (int e = 0; e < OFX_LAYER_EVENT_COUNT; e++)
             {
-                l->setup();
-                l->setSetup(true);
+                dispatchLists[e].clear();
+                for (layerIt it = layers.begin(); it != layers.end(); ++it)
+                {
+                    if(it->second->isInterestedIn((ofxLayerEvent) e))
+                    {
+                        dispatchLists[e].push_back(it->second);
+                    }
+                }
             }
-        	l->activate();
+            bDispatchDirty = false;
         }
+        return dispatchLists[event];
     }
-
+    
+    //Focus Stack, activation pushes a layer on top and deactivation takes it off again.
+    //Key and back style events go to the top layer and only move down the stack when it declines.
+    
+    void focusLayer(ofxLayer *l)
+    {
+        unfocusLayer(l);
+        focusStack.push_back(l);
+    }
+    
+    void unfocusLayer(ofxLayer *l)
+    {
+        vector<ofxLayer*>::iterator it = std::find(focusStack.begin(), focusStack.end(), l);
+        if(it != focusStack.end())
+        {
+            focusStack.erase(it);
+        }
+    }
+    
+    ofxLayer *getFocusedLayer()
+    {
+        for (size_t i = focusStack.size(); i-- > 0; )
+        {
+            if(focusStack[i]->isActive())
+            {
+                return focusStack[i];
+            }
+        }
+        return NULL;
+    }
+    
+    const vector<ofxLayer*>& getFocusStack() { return focusStack; }
+    
+    //handle(layer) returns whether the layer consumed the event. A layer declines by returning false or
+    //by not being interested, which includes its default handler having just cleared its interest bit.
+    //Active layers missing from the stack (activated directly rather than through the manager) come last.
+    template<class Handler>
+    bool routeToFocus(ofxLayerEvent event, Handler handle)
+    {
+        for (size_t i = focusStack.size(); i-- > 0; )
+        {
+            ofxLayer *l = focusStack[i];
+            if(l->isActive() && !l->isDead() && l->isInterestedIn(event) && handle(l) && l->isInterestedIn(event))
+            {
+                l->markDirty();
+                wake();
+                return true;
+            }
+            //the handler may have switched layers
+            i = MIN(i, focusStack.size());
+        }
+        vector<ofxLayer*> &list = getDispatchList(event);
+        for (size_t i = 0; i < list.size(); i++)
+        {
+            ofxLayer *l = list[i];
+            if(l->isActive() && !l->isDead() && std::find(focusStack.begin(), focusStack.end(), l) == focusStack.end()
+               && handle(l) && l->isInterestedIn(event))
+            {
+                l->markDirty();
+                wake();
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    //Every active layer interested in the event gets it, in map order. Only layers still interested after
+    //their handler ran are marked dirty, the default handlers clear the bit for events a layer ignores.
+    //Layers retired by an earlier handler stay allocated until the next update() and are skipped.
+    template<class Handler>
+    void dispatchToLayers(ofxLayerEvent event, Handler handle)
+    {
+        vector<ofxLayer*> &list = getDispatchList(event);
+        for (size_t i = 0; i < list.size(); i++)
+        {
+            ofxLayer *l = list[i];
+            if(l->isActive() && !l->isDead())
+            {
+                handle(l);
+                if(l->isInterestedIn(event))
+                {
+                    l->markDirty();
+                    wake();
+                }
+            }
+        }
+    }
+    
     void onDeleteLayer(ofxLayerEventArgs &args)
     {
         layerIt it = layers.find(args.layerName);
@@ -111,6 +433,8 @@ public:
         {
             ofxLayer *l = (ofxLayer *) it->second; 
             l->deactivate(); 
+            unfocusLayer(l);
+            refreshLayerTable();
         }        
     }
 
@@ -120,19 +444,97 @@ public:
         if (it != layers.end()) 
         {            
             args.sender->deactivate(); 
-            ofxLayer *l = (ofxLayer *) it->second;
-            if(!l->isSetup())
+            unfocusLayer(args.sender);
+            switchMessage = args.message;
+            if(snapshot.isOpen())
             {
-                l->setup();
-                l->setSetup(true);
-            }            
-            l->activate();
+                snapshot.setMessage(switchMessage);
+            }
+            ofxLayer *l = (ofxLayer *) it->second;
+            setupAndActivate(l);
         }          
     }
     
+    void setupAndActivate(ofxLayer *l)
+    {
+        if(!l->isSetup())
+        {
+            l->setup();
+            l->setSetup(true);
+            //a fresh layer lays itself out for the current window in setup
+            l->setLayoutSize(windowWidth >= 0 ? windowWidth : ofGetWidth(), windowHeight >= 0 ? windowHeight : ofGetHeight());
+#ifdef TARGET_OF_IPHONE
+            l->setLayoutOrientation(deviceOrientation);
+#endif
+        }
+        else
+        {
+            layoutLayer(l);
+        }
+        l->activate();
+        l->markDirty();
+        focusLayer(l);
+        refreshLayerTable();
+    }
+    
+    //Delivers the committed window size (and orientation) if it changed since the layer last laid out
+    void layoutLayer(ofxLayer *l)
+    {
+#ifndef TARGET_OPENGLES
+        if(windowWidth >= 0 && (l->getLayoutWidth() != windowWidth || l->getLayoutHeight() != windowHeight))
+        {
+            l->setLayoutSize(windowWidth, windowHeight);
+            l->windowResized(windowWidth, windowHeight);
+            l->markDirty();
+        }
+#endif
+#ifdef TARGET_OF_IPHONE
+        if(deviceOrientation >= 0 && l->getLayoutOrientation() != deviceOrientation)
+        {
+            l->setLayoutOrientation(deviceOrientation);
+            l->deviceOrientationChanged(deviceOrientation);
+            l->markDirty();
+        }
+#endif
+    }
+    
+    //Resize and orientation notifications are coalesced to one per frame, active layers get them here,
+    //inactive ones when they are next activated
+    void flushPendingLayout()
+    {
+        bool bChanged = false;
+        if(bResizePending)
+        {
+            windowWidth = pendingWidth;
+            windowHeight = pendingHeight;
+            bResizePending = false;
+            bChanged = true;
+        }
+#ifdef TARGET_OF_IPHONE
+        if(bOrientationPending)
+        {
+            deviceOrientation = pendingOrientation;
+            bOrientationPending = false;
+            bChanged = true;
+        }
+#endif
+        if(!bChanged)
+        {
+            return;
+        }
+        for (layerIt it = layers.begin(); it != layers.end(); ++it)
+        {
+            if(it->second->isSetup() && it->second->isActive())
+            {
+                layoutLayer(it->second);
+            }
+        }
+    }
+    
     void deleteLayer(ofxLayer *_layer)
     {
         _layer->setDead(true);
+        refreshLayerTable();
     }
     
 	void activateLayer(ofxLayer *_layer)
@@ -141,12 +543,7 @@ public:
         if (it != layers.end())
         {
             ofxLayer *l = (ofxLayer *) it->second;
-            if(!l->isSetup())
-            {
-                l->setup();
-                l->setSetup(true);
-            }            
-            l->activate(); 
+            setupAndActivate(l);
         }		
 	}
 	
@@ -163,13 +560,9 @@ public:
                     last->deactivate(); 
                 }
             }
+            focusStack.clear();
             ofxLayer *l = (ofxLayer *) it->second;
-            if(!l->isSetup())
-            {
-                l->setup();
-                l->setSetup(true);
-            }            
-            l->activate();             
+            setupAndActivate(l);            
         }
     }
     
@@ -186,13 +579,9 @@ public:
                     last->deactivate();
                 }
             }
+            focusStack.clear();
             ofxLayer *l = (ofxLayer *) it->second;
-            if(!l->isSetup())
-            {
-                l->setup();
-                l->setSetup(true);
-            }            
-            l->activate();             
+            setupAndActivate(l);            
         }
     }
     
@@ -214,11 +603,154 @@ public:
         return sharedAppData;
     }
     
+    ofxLayerAssetCache& getAssetCache()
+    {
+        return assetCache;
+    }
+    
     map<string, ofxLayer*> getLayers() const
     {
         return layers;
     }
     
+    //Snapshot of the layer names and their active/setup state that other threads can read
+    //through an ofxLayerTableReader while the main thread keeps adding and switching layers
+    const ofxLayerTablePublisher& getLayerTable() const
+    {
+        return layerTable;
+    }
+    
+    //Publishes a new table if the layers changed since the last one, main thread only
+    void refreshLayerTable()
+    {
+        const ofxLayerTable &published = layerTable.peek();
+        bool bChanged = published.size() != layers.size();
+        size_t index = 0;
+        for (layerIt it = layers.begin(); it != layers.end() && !bChanged; ++it, ++index)
+        {
+            bChanged = !(published.entries[index] == makeTableEntry(it->second));
+        }
+        if(!bChanged)
+        {
+            return;
+        }
+        ofxLayerTable *table = new ofxLayerTable();
+        table->entries.reserve(layers.size());
+        for (layerIt it = layers.begin(); it != layers.end(); ++it)
+        {
+            table->entries.push_back(makeTableEntry(it->second));
+            if(snapshot.isOpen())
+            {
+                syncSnapshot(it->second, published.find(it->first), table->entries.back());
+            }
+        }
+        bLayersChanged = true;
+        if(snapshot.isOpen())
+        {
+            for (size_t i = 0; i < published.size(); i++)
+            {
+                if(layers.find(published.entries[i].layerName) == layers.end())
+                {
+                    snapshot.removeLayer(published.entries[i].layerName);
+                }
+            }
+            snapshot.flush();
+        }
+        layerTable.publish(table);
+    }
+    
+    //Warm Start Snapshot
+    
+    //Maps the snapshot file and restores the layers that were active when it was last written: they are set up,
+    //activated and handed their saved blob, everything else stays lazy. Call it after adding the layers.
+    //Returns true if any layer was restored, so the app can fall back to its usual first screen otherwise.
+    bool enableSnapshot(string path, int numSlots = 64, int blobCapacity = 4096)
+    {
+        disableSnapshot();
+        if(!snapshot.open(path, numSlots, blobCapacity))
+        {
+            return false;
+        }
+        vector<string> restore = snapshot.getLayerNames(true);
+        switchMessage = snapshot.getMessage();
+        snapshot.clearLayerStates();
+        for (layerIt it = layers.begin(); it != layers.end(); ++it)
+        {
+            snapshot.setLayerState(it->first, it->second->isSetup(), it->second->isActive());
+        }
+        
+        bool bRestored = false;
+        for (size_t i = 0; i < restore.size(); i++)
+        {
+            layerIt it = layers.find(restore[i]);
+            if (it != layers.end())
+            {
+                setupAndActivate(it->second);
+                string blob;
+                if(snapshot.getBlob(restore[i], blob))
+                {
+                    if(it->second->isPipelined())
+                    {
+                        waitForPipeline();
+                    }
+                    it->second->deserialize(blob);
+                }
+                bRestored = true;
+            }
+        }
+        return bRestored;
+    }
+    
+    void disableSnapshot()
+    {
+        snapshot.close();
+    }
+    
+    //Writes the layer's serialize() blob into the snapshot now
+    void saveLayerState(ofxLayer *l)
+    {
+        if(!snapshot.isOpen() || !l->isSetup())
+        {
+            return;
+        }
+        //serialize() may read the update side state, let an in-flight updateAsync() finish first
+        if(l->isPipelined())
+        {
+            waitForPipeline();
+        }
+        string blob;
+        if(l->serialize(blob))
+        {
+            snapshot.setBlob(l->getLayerName(), blob);
+        }
+    }
+    
+    //message of the last switchLayer(name, message) a layer sent, restored from the snapshot on boot
+    string getSwitchMessage() { return switchMessage; }
+    
+    void syncSnapshot(ofxLayer *l, const ofxLayerTableEntry *before, const ofxLayerTableEntry &after)
+    {
+        if(before != NULL && before->bActive == after.bActive && before->bSetup == after.bSetup)
+        {
+            return;
+        }
+        snapshot.setLayerState(after.layerName, after.bSetup, after.bActive);
+        if(before != NULL && before->bActive && !after.bActive)
+        {
+            saveLayerState(l);
+        }
+    }
+    
+    static ofxLayerTableEntry makeTableEntry(ofxLayer *l)
+    {
+        ofxLayerTableEntry entry;
+        entry.layerName = l->getLayerName();
+        entry.bActive = l->isActive();
+        entry.bSetup = l->isSetup();
+        entry.bDead = l->isDead();
+        return entry;
+    }
+    
     vector<string> getLayerNames()
     {
         vector<string> layerNames; 
@@ -270,53 +802,322 @@ public:
     
     void update()
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
+        //finish last frame's pipelined updates and hand their state to draw before anything else touches the layers
+        waitForPipeline();
+        for (size_t i = 0; i < pipelinedLayers.size(); i++)
         {
-            if(layer->second->isDead())
+            if(!pipelinedLayers[i]->isDead())
             {
-                ofxLayer *l = layer->second;
-
-                if(l->isSetup())
+                pipelinedLayers[i]->publish();
+                bLayersChanged = true;
+            }
+        }
+        pipelinedLayers.clear();
+        sweepDeadLayers();
+        
+        flushPendingLayout();
+        //layers may add, replace or delete layers from update(), so walk a copy and skip the ones that died meanwhile
+        updatingLayers.clear();
+        for (layerIt it = layers.begin(); it != layers.end(); ++it)
+        {
+            updatingLayers.push_back(it->second);
+        }
+        for (size_t i = 0; i < updatingLayers.size(); i++)
+        {
+            ofxLayer *l = updatingLayers[i];
+            if(l->isActive() && !l->isDead())
+            {
+                l->setChanged(l->isDirty());
+                if(bIdleMode && !l->hasChanged())
                 {
-                    if(l->isActive())
-                    {
-                        l->deactivate();
-                    }
-                    l->exit();
+                    idleStats.updatesSkipped++;
+                }
+                else if(l->isPipelined())
+                {
+                    l->clearDirty();
+                    pipelinedLayers.push_back(l);
+                    idleStats.updatesRun++;
+                }
+                else
+                {
+                    l->clearDirty();
+                    l->update();
+                    idleStats.updatesRun++;
                 }
-                delete l;
-                layers.erase(layer);                
             }
-            else if(layer->second->isActive())
+        }
+        //next frame's state is simulated while this one gets drawn
+        for (size_t i = 0; i < pipelinedLayers.size(); i++)
+        {
+            getPipelinePool().run(pipelineGroup, std::bind(&ofxLayer::updateAsync, pipelinedLayers[i]));
+        }
+        //layers can (de)activate themselves directly, catch that once a frame
+        refreshLayerTable();
+        
+        idleStats.frames++;
+        bVisibleChange = bLayersChanged;
+        bLayersChanged = false;
+        for (layerIt it = layers.begin(); it != layers.end() && !bVisibleChange; ++it)
+        {
+            bVisibleChange = it->second->isActive() && (it->second->hasChanged() || it->second->isDirty());
+        }
+        if(bVisibleChange)
+        {
+            wake();
+        }
+        else if(bIdleMode)
+        {
+            //clean frames in a row, capped, draw() needs to know about the first two
+            cleanFrames = MIN(cleanFrames + 1, MAX(idleDelayFrames, 2));
+            if(!bSleeping && cleanFrames >= idleDelayFrames)
             {
-                layer->second->update();
+                bSleeping = true;
+                ofSetFrameRate(idleFrameRate);
             }
         }
     }
     
     void draw()
     {
+        //without an automatic background clear the last frame stays up, so an unchanged frame needn't be drawn at all.
+        //The buffers still get swapped, so the first clean frame is drawn too: the last change has to be in both of them.
+        if(bIdleMode && !bVisibleChange && cleanFrames >= 2 && !ofGetBackgroundAuto())
+        {
+            for (layerIt it = layers.begin(); it != layers.end(); ++it)
+            {
+                if(it->second->isActive()) { idleStats.drawsSkipped++; }
+            }
+            idleStats.idleFrames++;
+            return;
+        }
+        recordDrawLists();
         for (layer= layers.begin(); layer != layers.end(); ++layer )
         {
-            if(layer->second->isActive()) { layer->second->draw(); }
+            if(layer->second->isActive())
+            {
+                if(layer->second->isRetainedDraw())
+                {
+                    layer->second->getDrawList().replay(*drawBackend);
+                }
+                else
+                {
+                    layer->second->draw();
+                }
+                idleStats.drawsRun++;
+            }
         }
     }
     
+    //Blocks until the pipelined layers' updateAsync() calls started by the last update() are done,
+    //for when the main thread has to touch their update state outside of publish()
+    void waitForPipeline()
+    {
+        pipelineGroup.wait();
+    }
+    
+    //Idle Mode
+    
+    //Skips update() for clean layers, skips whole frames nothing changed in from the second one on (only when
+    //ofSetBackgroundAuto(false), otherwise the cleared frame has to be redrawn) and drops the loop to idleFrameRate after idleDelayFrames
+    //clean frames. Input or a dirty layer brings the frame rate straight back.
+    void setIdleMode(bool _bIdleMode, float _idleFrameRate = 5, int _idleDelayFrames = 30)
+    {
+        if(_bIdleMode && !bIdleMode)
+        {
+            activeFrameRate = ofGetTargetFrameRate() > 0 ? ofGetTargetFrameRate() : 60;
+        }
+        if(!_bIdleMode)
+        {
+            wake();
+        }
+        bIdleMode = _bIdleMode;
+        idleFrameRate = _idleFrameRate;
+        idleDelayFrames = _idleDelayFrames;
+    }
+    
+    bool getIdleMode() { return bIdleMode; }
+    
+    //whether any active layer changed in the last update(), or layers were (de)activated, added or removed
+    bool hasVisibleChanges() { return bVisibleChange; }
+    
+    bool isSleeping() { return bSleeping; }
+    
+    const ofxLayerIdleStats& getIdleStats() { return idleStats; }
+    
+    void resetIdleStats() { idleStats = ofxLayerIdleStats(); }
+    
+    //back to the full frame rate if idle mode had slowed the loop down
+    void wake()
+    {
+        cleanFrames = 0;
+        if(bSleeping)
+        {
+            bSleeping = false;
+            ofSetFrameRate(activeFrameRate);
+        }
+    }
+    
+    //Record the active retained layers' draw lists, on the worker pool when parallel recording is on
+    void recordDrawLists()
+    {
+        recordingLayers.clear();
+        for (layerIt it = layers.begin(); it != layers.end(); ++it)
+        {
+            //a clean layer's list from an earlier frame is still good
+            if(it->second->isActive() && it->second->isRetainedDraw() && (!bIdleMode || it->second->hasChanged() || it->second->isDirty()))
+            {
+                recordingLayers.push_back(it->second);
+            }
+        }
+        if(bParallelRecording && recordingLayers.size() > 1)
+        {
+            ofxLayerTaskGroup group;
+            for (size_t i = 0; i < recordingLayers.size(); i++)
+            {
+                getWorkerPool().run(group, std::bind(&ofxLayerManager::recordLayer, recordingLayers[i]));
+            }
+            group.wait();
+        }
+        else
+        {
+            for (size_t i = 0; i < recordingLayers.size(); i++)
+            {
+                recordLayer(recordingLayers[i]);
+            }
+        }
+    }
+    
+    static void recordLayer(ofxLayer *l)
+    {
+        l->getDrawList().clear();
+        l->record(l->getDrawList());
+    }
+    
+    void setParallelRecording(bool _bParallelRecording) { bParallelRecording = _bParallelRecording; }
+    bool getParallelRecording() { return bParallelRecording; }
+    
+    //Where retained layers' draw lists are replayed, NULL restores the default GL backend.
+    //An ofxLayerNullDrawBackend lets the whole draw path run headless.
+    void setDrawBackend(ofxLayerDrawBackend *backend)
+    {
+        drawBackend = backend != NULL ? backend : &glDrawBackend;
+    }
+    
+    ofxLayerDrawBackend* getDrawBackend() { return drawBackend; }
+    
     void exit()
     {
         cout << "Exiting LayerManager" << endl;
 
         disable();
-        for (layer = layers.begin(); layer != layers.end(); ++layer )
+        waitForPipeline();
+        pipelinedLayers.clear();
+        destroyRetiredLayers();
+        if(snapshot.isOpen())
+        {
+            //keep what was active for the next boot instead of recording the teardown
+            for (layer = layers.begin(); layer != layers.end(); ++layer)
+            {
+                saveLayerState(layer->second);
+            }
+            disableSnapshot();
+        }
+        exitTimings.clear();
+        exitTimings.resize(layers.size());
+        
+        //layers flagged independent go to the worker pool, everything else is torn down here in order
+        ofxLayerTaskGroup group;
+        size_t index = 0;
+        for (layer = layers.begin(); layer != layers.end(); ++layer, ++index)
         {
             ofxLayer *l = layer->second;
-            if(l->isSetup())
+            removeLayerListeners(l);
+            lifecycleStats.layersDeleted++;
+            if(bParallelExit && l->isIndependentExit())
             {
-                l->exit();
+                getWorkerPool().run(group, std::bind(&ofxLayerManager::shutdownLayer, this, l, &exitTimings[index], true));
+            }
+            else
+            {
+                shutdownLayer(l, &exitTimings[index], false);
             }
-            delete l;
         }
+        group.wait();
 		layers.clear();
+        focusStack.clear();
+        bDispatchDirty = true;
+        refreshLayerTable();
+        
+        for (size_t i = 0; i < exitTimings.size(); i++)
+        {
+            cout << "  " << exitTimings[i].layerName << ": " << exitTimings[i].milliseconds << " ms" << (exitTimings[i].bParallel ? " (parallel)" : "") << endl;
+        }
+    }
+    
+    //Run the independent layers' exit() and destructor concurrently during exit()
+    void setParallelExit(bool _bParallelExit) { bParallelExit = _bParallelExit; }
+    bool getParallelExit() { return bParallelExit; }
+    
+    //Skip the layer destructors during exit(), for when the process is about to terminate anyway
+    //and the OS will reclaim the memory. exit() is still called on every set up layer.
+    void setFastExit(bool _bFastExit) { bFastExit = _bFastExit; }
+    bool getFastExit() { return bFastExit; }
+    
+    //Per layer shutdown time of the last exit()
+    const vector<ofxLayerExitTiming>& getExitTimings() { return exitTimings; }
+    
+    //Size of the worker pool, 0 means one per hardware thread. Only takes effect before the pool is first used.
+    void setNumWorkerThreads(size_t _numWorkerThreads) { numWorkerThreads = _numWorkerThreads; }
+    
+    ofxLayerWorkerPool& getWorkerPool()
+    {
+        if(workerPool == NULL)
+        {
+            workerPool = new ofxLayerWorkerPool(numWorkerThreads);
+        }
+        return *workerPool;
+    }
+    
+    //Pipelined updateAsync() calls get a pool of their own, queued behind them in the shared pool the
+    //draw recording would wait for the whole simulation. 0 means one per hardware thread, set it before the first update().
+    void setNumPipelineThreads(size_t _numPipelineThreads) { numPipelineThreads = _numPipelineThreads; }
+    
+    ofxLayerWorkerPool& getPipelinePool()
+    {
+        if(pipelinePool == NULL)
+        {
+            pipelinePool = new ofxLayerWorkerPool(numPipelineThreads);
+        }
+        return *pipelinePool;
+    }
+    
+    //Asset cache loads get a pool of their own too, so draw recording and parallel exit never queue behind
+    //a decode, and a job waiting on an asset can't hold the worker its load needs. 0 means one per hardware thread.
+    void setNumLoadThreads(size_t _numLoadThreads) { numLoadThreads = _numLoadThreads; }
+    
+    ofxLayerWorkerPool& getLoadPool()
+    {
+        if(loadPool == NULL)
+        {
+            loadPool = new ofxLayerWorkerPool(numLoadThreads);
+        }
+        return *loadPool;
+    }
+    
+    void shutdownLayer(ofxLayer *l, ofxLayerExitTiming *timing, bool bParallel)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        timing->layerName = l->getLayerName();
+        timing->bParallel = bParallel;
+        if(l->isSetup())
+        {
+            l->exit();
+        }
+        if(!bFastExit)
+        {
+            delete l;
+        }
+        timing->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     }
     
 #ifdef TARGET_OPENGLES
@@ -332,30 +1133,25 @@ public:
     
     void onTouchUp(ofTouchEventArgs &data) 
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->touchUp(data); }        
+        dispatchToLayers(OFX_LAYER_EVENT_TOUCH_UP, [&data](ofxLayer *l) { l->touchUp(data); });
     }
     
     void onTouchDown(ofTouchEventArgs &data)
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->touchDown(data); }
+        dispatchToLayers(OFX_LAYER_EVENT_TOUCH_DOWN, [&data](ofxLayer *l) { l->touchDown(data); });
     }
     
     void onTouchMoved(ofTouchEventArgs &data) 
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->touchMoved(data); }        
+        dispatchToLayers(OFX_LAYER_EVENT_TOUCH_MOVED, [&data](ofxLayer *l) { l->touchMoved(data); });
     }
     void onTouchCancelled(ofTouchEventArgs &data)
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->touchCancelled(data); }
+        dispatchToLayers(OFX_LAYER_EVENT_TOUCH_CANCELLED, [&data](ofxLayer *l) { l->touchCancelled(data); });
     }
     void onTouchDoubleTap(ofTouchEventArgs &data)
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->touchDoubleTap(data); }
+        dispatchToLayers(OFX_LAYER_EVENT_TOUCH_DOUBLE_TAP, [&data](ofxLayer *l) { l->touchDoubleTap(data); });
     }
 #else
     //Keyboard Callbacks
@@ -367,15 +1163,14 @@ public:
     
     void onKeyPressed(ofKeyEventArgs& data)
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->keyPressed(data.key); }
-        
+        int key = data.key;
+        routeToFocus(OFX_LAYER_EVENT_KEY_PRESSED, [key](ofxLayer *l) { l->keyPressed(key); return true; });
     }
     
     void onKeyReleased(ofKeyEventArgs& data)
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->keyReleased(data.key); }
+        int key = data.key;
+        routeToFocus(OFX_LAYER_EVENT_KEY_RELEASED, [key](ofxLayer *l) { l->keyReleased(key); return true; });
     }    
     //Mouse Callbacks
     void enableMouseEventCallbacks()
@@ -388,26 +1183,22 @@ public:
     
     void onMouseReleased(ofMouseEventArgs& data) 
     { 
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->mouseReleased(data); }         
+        dispatchToLayers(OFX_LAYER_EVENT_MOUSE_RELEASED, [&data](ofxLayer *l) { l->mouseReleased(data); });
     }
     
     void onMousePressed(ofMouseEventArgs& data) 
     { 
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->mousePressed(data); }         
+        dispatchToLayers(OFX_LAYER_EVENT_MOUSE_PRESSED, [&data](ofxLayer *l) { l->mousePressed(data); });
     }
     
     void onMouseMoved(ofMouseEventArgs& data) 
     { 
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->mouseMoved(data); }         
+        dispatchToLayers(OFX_LAYER_EVENT_MOUSE_MOVED, [&data](ofxLayer *l) { l->mouseMoved(data); });
     }
     
     void onMouseDragged(ofMouseEventArgs& data) 
     { 
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->mouseDragged(data); }             
+        dispatchToLayers(OFX_LAYER_EVENT_MOUSE_DRAGGED, [&data](ofxLayer *l) { l->mouseDragged(data); });
     }
     
     //Window Resize Callback
@@ -418,13 +1209,10 @@ public:
     
     void onWindowResized(ofResizeEventArgs& data) 
     { 
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-        {
-            if(layer->second->isSetup())
-            {   
-                layer->second->windowResized(data.width, data.height); 
-            }
-        }
+        pendingWidth = data.width;
+        pendingHeight = data.height;
+        bResizePending = true;
+        wake();
     }       
 #endif      
     
@@ -480,50 +1268,43 @@ public:
     
     void onKeyDown(int keyCode)
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->onKeyDown(keyCode); }             
+        routeToFocus(OFX_LAYER_EVENT_KEY_DOWN, [keyCode](ofxLayer *l) { l->onKeyDown(keyCode); return true; });
     }    
     
 	void onKeyUp(int keyCode)
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->onKeyUp(keyCode); }             
+        routeToFocus(OFX_LAYER_EVENT_KEY_UP, [keyCode](ofxLayer *l) { l->onKeyUp(keyCode); return true; });
     }
     
+    //back and menu items carry the answer themselves, they bubble down while layers return false
 	bool backPressed()
     { 
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { return layer->second->backPressed(); }             
+        return routeToFocus(OFX_LAYER_EVENT_BACK_PRESSED, [](ofxLayer *l) { return l->backPressed(); });
     }
 
 	void menuPressed()
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { layer->second->menuPressed(); }             
+        routeToFocus(OFX_LAYER_EVENT_MENU_PRESSED, [](ofxLayer *l) { l->menuPressed(); return true; });
     }
     
 	bool menuItemSelected(string menu_id_str)
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { return layer->second->menuItemSelected(menu_id_str); }             
+        return routeToFocus(OFX_LAYER_EVENT_MENU_ITEM_SELECTED, [&menu_id_str](ofxLayer *l) { return l->menuItemSelected(menu_id_str); });
     }    
 	
     bool menuItemChecked(string menu_id_str, bool checked)
     { 
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { return layer->second->menuItemChecked(menu_id_str, checked); }             
+        return routeToFocus(OFX_LAYER_EVENT_MENU_ITEM_CHECKED, [&menu_id_str, checked](ofxLayer *l) { return l->menuItemChecked(menu_id_str, checked); });
     }
     
 	void okPressed()
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { return layer->second->okPressed(); }                 
+        routeToFocus(OFX_LAYER_EVENT_OK_PRESSED, [](ofxLayer *l) { l->okPressed(); return true; });
     }
 	
     void cancelPressed()
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-            if(layer->second->isActive()) { return layer->second->cancelPressed(); }                 
+        routeToFocus(OFX_LAYER_EVENT_CANCEL_PRESSED, [](ofxLayer *l) { l->cancelPressed(); return true; });
     }        
 
 #endif      
@@ -565,13 +1346,9 @@ public:
     
     void deviceOrientationChanged(int newOrientation)
     {
-        for (layer= layers.begin(); layer != layers.end(); ++layer )
-        {
-            if(layer->second->isSetup())
-            {
-                layer->second->deviceOrientationChanged(newOrientation);
-            }
-        }
+        pendingOrientation = newOrientation;
+        bOrientationPending = true;
+        wake();
     }
     
 #endif
@@ -580,6 +1357,55 @@ private:
     layerIt layer; 
     map<string, ofxLayer*> layers;    
     ofxSharedAppData *sharedAppData; 
+    ofxLayerTablePublisher layerTable;
+    ofxLayerSnapshot snapshot;
+    ofxLayerAssetCache assetCache;
+    string switchMessage;
+    vector<ofxLayer*> dispatchLists[OFX_LAYER_EVENT_COUNT];
+    vector<ofxLayer*> focusStack;
+    
+    bool bIdleMode;
+    bool bSleeping;
+    bool bVisibleChange;
+    bool bLayersChanged;
+    int cleanFrames;
+    int idleDelayFrames;
+    float idleFrameRate;
+    float activeFrameRate;
+    ofxLayerIdleStats idleStats;
+    ofxLayerLifecycleStats lifecycleStats;
+    
+    vector<ofxLayer*> pipelinedLayers;     //their updateAsync() is in flight until the next update()
+    vector<ofxLayer*> retiredLayers;       //out of the map, deleted by the next update()
+    vector<ofxLayer*> updatingLayers;
+    ofxLayerTaskGroup pipelineGroup;
+    bool bDispatchDirty;
+    
+    int windowWidth;
+    int windowHeight;
+    int pendingWidth;
+    int pendingHeight;
+    bool bResizePending;
+    
+    bool bParallelExit;
+    bool bFastExit;
+    vector<ofxLayerExitTiming> exitTimings;
+    ofxLayerWorkerPool *workerPool;
+    size_t numWorkerThreads;
+    ofxLayerWorkerPool *pipelinePool;
+    size_t numPipelineThreads;
+    ofxLayerWorkerPool *loadPool;
+    size_t numLoadThreads;
+    
+    bool bParallelRecording;
+    vector<ofxLayer*> recordingLayers;
+    ofxLayerGLDrawBackend glDrawBackend;
+    ofxLayerDrawBackend *drawBackend;
+#ifdef TARGET_OF_IPHONE
+    int deviceOrientation;
+    int pendingOrientation;
+    bool bOrientationPending;
+#endif
 };
 
 #endif 
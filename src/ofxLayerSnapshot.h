@@ -0,0 +1,343 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#ifndef OFXLAYERSNAPSHOT
+#define OFXLAYERSNAPSHOT
+
+#include "ofMain.h"
+#include <cstring>
+
+#ifdef TARGET_WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define OFX_LAYER_SNAPSHOT_VERSION 1
+#define OFX_LAYER_SNAPSHOT_NAME_LENGTH 64
+#define OFX_LAYER_SNAPSHOT_MESSAGE_LENGTH 256
+
+struct ofxLayerSnapshotHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t numSlots;
+    uint32_t blobCapacity;
+    uint32_t messageLength;
+    char message[OFX_LAYER_SNAPSHOT_MESSAGE_LENGTH];
+};
+
+//one per layer, followed by blobCapacity bytes of the layer's own serialized state
+struct ofxLayerSnapshotSlot
+{
+    char layerName[OFX_LAYER_SNAPSHOT_NAME_LENGTH];     //empty means free
+    uint8_t bSetup;
+    uint8_t bActive;
+    uint8_t reserved[2];
+    uint32_t blobSize;
+};
+
+static_assert(sizeof(ofxLayerSnapshotHeader) % alignof(ofxLayerSnapshotSlot) == 0, "the first slot has to start aligned");
+
+//Fixed layout file mapped into memory, so recording a layer change is a few byte writes in place
+//rather than rewriting the whole file. Layer names longer than 63 chars and blobs larger than the
+//blob capacity are not stored.
+class ofxLayerSnapshot
+{
+public:
+    ofxLayerSnapshot()
+    {
+        data = NULL;
+        size = 0;
+#ifdef TARGET_WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+#else
+        fd = -1;
+#endif
+    }
+    
+    ~ofxLayerSnapshot()
+    {
+        close();
+    }
+    
+    //Maps the file, creating or resetting it when it doesn't match the requested layout.
+    //The blob capacity is rounded up so every slot stays aligned. Returns false if the file couldn't be mapped.
+    bool open(string path, int numSlots = 64, int blobCapacity = 4096)
+    {
+        close();
+        blobCapacity = (blobCapacity + alignof(ofxLayerSnapshotSlot) - 1) / alignof(ofxLayerSnapshotSlot) * alignof(ofxLayerSnapshotSlot);
+        size = sizeof(ofxLayerSnapshotHeader) + (size_t) numSlots * (sizeof(ofxLayerSnapshotSlot) + blobCapacity);
+        if(!map(ofToDataPath(path, true)))
+        {
+            ofLogError("ofxLayerSnapshot") << "couldn't map " << path;
+            close();
+            return false;
+        }
+        ofxLayerSnapshotHeader *h = header();
+        if(memcmp(h->magic, "OFXL", 4) != 0 || h->version != OFX_LAYER_SNAPSHOT_VERSION
+           || h->numSlots != (uint32_t) numSlots || h->blobCapacity != (uint32_t) blobCapacity)
+        {
+            memset(data, 0, size);
+            memcpy(h->magic, "OFXL", 4);
+            h->version = OFX_LAYER_SNAPSHOT_VERSION;
+            h->numSlots = numSlots;
+            h->blobCapacity = blobCapacity;
+        }
+        return true;
+    }
+    
+    void close()
+    {
+        if(data != NULL)
+        {
+            flush();
+        }
+        unmap();
+        data = NULL;
+        size = 0;
+    }
+    
+    bool isOpen() { return data != NULL; }
+    
+    //asks the OS to write dirty pages back without waiting for it
+    void flush()
+    {
+#ifdef TARGET_WIN32
+        FlushViewOfFile(data, 0);
+#else
+        msync(data, size, MS_ASYNC);
+#endif
+    }
+    
+    string getMessage()
+    {
+        ofxLayerSnapshotHeader *h = header();
+        return string(h->message, MIN(h->messageLength, (uint32_t) OFX_LAYER_SNAPSHOT_MESSAGE_LENGTH));
+    }
+    
+    void setMessage(const string &message)
+    {
+        ofxLayerSnapshotHeader *h = header();
+        size_t length = MIN(message.size(), (size_t) OFX_LAYER_SNAPSHOT_MESSAGE_LENGTH);
+        memcpy(h->message, message.data(), length);
+        h->messageLength = length;
+    }
+    
+    vector<string> getLayerNames(bool bActiveOnly)
+    {
+        vector<string> names;
+        for(uint32_t i = 0; i < header()->numSlots; i++)
+        {
+            ofxLayerSnapshotSlot *s = slot(i);
+            if(s->layerName[0] != 0 && (!bActiveOnly || s->bActive))
+            {
+                names.push_back(s->layerName);
+            }
+        }
+        return names;
+    }
+    
+    bool wasSetup(const string &layerName)
+    {
+        ofxLayerSnapshotSlot *s = findSlot(layerName, false);
+        return s != NULL && s->bSetup;
+    }
+    
+    bool wasActive(const string &layerName)
+    {
+        ofxLayerSnapshotSlot *s = findSlot(layerName, false);
+        return s != NULL && s->bActive;
+    }
+    
+    void setLayerState(const string &layerName, bool bSetup, bool bActive)
+    {
+        ofxLayerSnapshotSlot *s = findSlot(layerName, true);
+        if(s != NULL)
+        {
+            s->bSetup = bSetup;
+            s->bActive = bActive;
+        }
+    }
+    
+    //forget set up and active flags of every layer but keep their blobs
+    void clearLayerStates()
+    {
+        for(uint32_t i = 0; i < header()->numSlots; i++)
+        {
+            slot(i)->bSetup = false;
+            slot(i)->bActive = false;
+        }
+    }
+    
+    void removeLayer(const string &layerName)
+    {
+        ofxLayerSnapshotSlot *s = findSlot(layerName, false);
+        if(s != NULL)
+        {
+            memset(s, 0, sizeof(ofxLayerSnapshotSlot));
+        }
+    }
+    
+    bool getBlob(const string &layerName, string &blob)
+    {
+        ofxLayerSnapshotSlot *s = findSlot(layerName, false);
+        if(s == NULL || s->blobSize == 0)
+        {
+            return false;
+        }
+        blob.assign(blobData(s), s->blobSize);
+        return true;
+    }
+    
+    bool setBlob(const string &layerName, const string &blob)
+    {
+        if(blob.size() > header()->blobCapacity)
+        {
+            ofLogWarning("ofxLayerSnapshot") << layerName << " state is " << blob.size() << " bytes, capacity is " << header()->blobCapacity;
+            return false;
+        }
+        ofxLayerSnapshotSlot *s = findSlot(layerName, true);
+        if(s == NULL)
+        {
+            return false;
+        }
+        //size goes to zero first so a crash halfway through leaves no blob rather than a torn one
+        s->blobSize = 0;
+        memcpy(blobData(s), blob.data(), blob.size());
+        s->blobSize = blob.size();
+        return true;
+    }
+    
+private:
+    ofxLayerSnapshotHeader* header() { return (ofxLayerSnapshotHeader *) data; }
+    
+    ofxLayerSnapshotSlot* slot(uint32_t i)
+    {
+        return (ofxLayerSnapshotSlot *) (data + sizeof(ofxLayerSnapshotHeader) + i * (sizeof(ofxLayerSnapshotSlot) + header()->blobCapacity));
+    }
+    
+    char* blobData(ofxLayerSnapshotSlot *s) { return (char *) s + sizeof(ofxLayerSnapshotSlot); }
+    
+    ofxLayerSnapshotSlot* findSlot(const string &layerName, bool bCreate)
+    {
+        if(data == NULL || layerName.empty() || layerName.size() >= OFX_LAYER_SNAPSHOT_NAME_LENGTH)
+        {
+            return NULL;
+        }
+        ofxLayerSnapshotSlot *free = NULL;
+        for(uint32_t i = 0; i < header()->numSlots; i++)
+        {
+            ofxLayerSnapshotSlot *s = slot(i);
+            if(s->layerName[0] == 0)
+            {
+                if(free == NULL) { free = s; }
+            }
+            else if(layerName == s->layerName)
+            {
+                return s;
+            }
+        }
+        if(bCreate && free != NULL)
+        {
+            memset(free, 0, sizeof(ofxLayerSnapshotSlot));
+            memcpy(free->layerName, layerName.c_str(), layerName.size() + 1);
+            return free;
+        }
+        return NULL;
+    }
+    
+#ifdef TARGET_WIN32
+    bool map(const string &path)
+    {
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if(file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        //mapping a larger size grows the file, a smaller existing one is reset in open()
+        mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, (DWORD) size, NULL);
+        if(mapping == NULL)
+        {
+            return false;
+        }
+        data = (char *) MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        return data != NULL;
+    }
+    
+    void unmap()
+    {
+        if(data != NULL) { UnmapViewOfFile(data); }
+        if(mapping != NULL) { CloseHandle(mapping); }
+        if(file != INVALID_HANDLE_VALUE) { CloseHandle(file); }
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+    }
+    
+    HANDLE file;
+    HANDLE mapping;
+#else
+    bool map(const string &path)
+    {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if(fd < 0)
+        {
+            return false;
+        }
+        struct stat info;
+        if(fstat(fd, &info) != 0 || ((size_t) info.st_size != size && ftruncate(fd, size) != 0))
+        {
+            return false;
+        }
+        void *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(mapped == MAP_FAILED)
+        {
+            return false;
+        }
+        data = (char *) mapped;
+        return true;
+    }
+    
+    void unmap()
+    {
+        if(data != NULL) { munmap(data, size); }
+        if(fd >= 0) { ::close(fd); }
+        fd = -1;
+    }
+    
+    int fd;
+#endif
+    
+    ofxLayerSnapshot(const ofxLayerSnapshot&);
+    ofxLayerSnapshot& operator=(const ofxLayerSnapshot&);
+    
+    char *data;
+    size_t size;
+};
+
+#endif
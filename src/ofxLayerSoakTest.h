@@ -0,0 +1,212 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#ifndef OFXLAYERSOAKTEST
+#define OFXLAYERSOAKTEST
+
+#include "ofxLayerManager.h"
+#include <cstdio>
+
+#if defined(TARGET_LINUX) || defined(TARGET_ANDROID) || defined(__linux__)
+#include <unistd.h>
+#elif defined(TARGET_OSX) || defined(TARGET_OF_IPHONE) || defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+//Throwaway layer the soak test churns: holds a payload between setup and exit, records a small draw list
+class ofxLayerSoakLayer : public ofxLayer
+{
+public:
+    ofxLayerSoakLayer(string name, size_t _payloadBytes)
+    {
+        layerName = name;
+        payloadBytes = _payloadBytes;
+        setRetainedDraw(true);
+    }
+    
+    void setup() { payload.assign(payloadBytes, 0); }
+    void exit() { vector<char>().swap(payload); }
+    
+    void update()
+    {
+        if(!payload.empty()) { payload[ofGetFrameNum() % payload.size()]++; }
+    }
+    
+    void record(ofxLayerDrawList &list)
+    {
+        list.pushMatrix();
+        list.translate(10, 10);
+        list.drawRectangle(0, 0, 100, 100);
+        list.drawBitmapString(layerName, 0, 0);
+        list.popMatrix();
+    }
+    
+    size_t getMemoryUsage() { return ofxLayer::getMemoryUsage() + payload.capacity(); }
+    
+private:
+    size_t payloadBytes;
+    vector<char> payload;
+};
+
+struct ofxLayerSoakReport
+{
+    unsigned long long cycles;
+    size_t residentBytesStart;
+    size_t residentBytesEnd;
+    size_t layerListenersEnd;
+    size_t liveLayersEnd;
+    map<string, size_t> layerBytesEnd;  //getMemoryUsage() of each live layer at the end
+    double frameMicrosStart;    //mean update + draw over the first reporting window
+    double frameMicrosEnd;      //and over the last one
+    bool bListenersLeaked;      //more listeners than OFX_LAYER_LISTENERS_PER_LAYER per live layer at any report
+};
+
+//Churns add/replace, switch and delete cycles (one frame after each step) through a manager with no window, driving update() and draw()
+//against a null draw backend, and reports memory growth, listener counts and frame time drift.
+//Meant to run for millions of cycles from a headless app (ofAppNoWindow), example-soakTest is one:
+//
+//  ofxLayerManager manager;
+//  ofxLayerSoakTest soak(manager);
+//  ofxLayerSoakReport report = soak.run(10000000);
+class ofxLayerSoakTest
+{
+public:
+    ofxLayerSoakTest(ofxLayerManager &_manager) : manager(_manager)
+    {
+        numNames = 16;
+        payloadBytes = 64 * 1024;
+        windowMicros = 0;
+        windowFrames = 0;
+    }
+    
+    //fewer names than cycles means adds keep hitting existing names and go through replacement
+    void setNumNames(int _numNames) { numNames = MAX(_numNames, 1); }
+    void setPayloadBytes(size_t _payloadBytes) { payloadBytes = _payloadBytes; }
+    
+    ofxLayerSoakReport run(unsigned long long cycles, unsigned long long reportEvery = 100000)
+    {
+        ofxLayerNullDrawBackend nullBackend;
+        ofxLayerDrawBackend *previousBackend = manager.getDrawBackend();
+        manager.setDrawBackend(&nullBackend);
+        //the soak drives update and draw itself
+        manager.disable();
+        
+        ofxLayerSoakReport report;
+        report.cycles = cycles;
+        report.residentBytesStart = getResidentBytes();
+        report.frameMicrosStart = 0;
+        report.frameMicrosEnd = 0;
+        report.bListenersLeaked = false;
+        
+        windowMicros = 0;
+        windowFrames = 0;
+        for (unsigned long long i = 0; i < cycles; i++)
+        {
+            //adds wrap around the names and replace live layers, switches land on a different name
+            //(which may not exist right now) and every third cycle deletes whatever is active
+            manager.addLayer(new ofxLayerSoakLayer("soak" + ofToString(i % numNames), payloadBytes));
+            frame();
+            manager.switchLayer("soak" + ofToString((i * 7) % numNames));
+            frame();
+            ofxLayer *active = manager.getActiveLayer();
+            if(i % 3 == 0 && active != NULL)
+            {
+                active->deleteMe();
+            }
+            frame();
+            
+            if((i + 1) % reportEvery == 0 || i + 1 == cycles)
+            {
+                double mean = windowMicros / windowFrames;
+                if(report.frameMicrosStart == 0) { report.frameMicrosStart = mean; }
+                report.frameMicrosEnd = mean;
+                ofxLayerLifecycleStats stats = manager.getLifecycleStats();
+                report.bListenersLeaked |= stats.layerListeners > stats.liveLayers * OFX_LAYER_LISTENERS_PER_LAYER;
+                cout << "ofxLayerSoakTest: " << (i + 1) << " cycles, rss " << getResidentBytes() / 1024 << " KB, "
+                     << stats.liveLayers << " layers, " << stats.layerListeners << " listeners, "
+                     << stats.layerBytes / 1024 << " KB in layers, " << mean << " us/frame" << endl;
+                windowMicros = 0;
+                windowFrames = 0;
+            }
+        }
+        
+        ofxLayerLifecycleStats stats = manager.getLifecycleStats();
+        report.residentBytesEnd = getResidentBytes();
+        report.layerListenersEnd = stats.layerListeners;
+        report.liveLayersEnd = stats.liveLayers;
+        report.layerBytesEnd = stats.layerBytesByName;
+        report.bListenersLeaked |= stats.layerListeners > stats.liveLayers * OFX_LAYER_LISTENERS_PER_LAYER;
+        cout << "ofxLayerSoakTest: rss " << (long long) (report.residentBytesEnd - report.residentBytesStart) / 1024 << " KB growth, frame time "
+             << report.frameMicrosStart << " -> " << report.frameMicrosEnd << " us" << (report.bListenersLeaked ? ", LISTENERS LEAKED" : "") << endl;
+        
+        manager.enable();
+        manager.setDrawBackend(previousBackend);
+        return report;
+    }
+    
+    //resident set size of the process, 0 where it isn't known
+    static size_t getResidentBytes()
+    {
+#if defined(TARGET_LINUX) || defined(TARGET_ANDROID) || defined(__linux__)
+        FILE *statm = fopen("/proc/self/statm", "r");
+        if(statm == NULL)
+        {
+            return 0;
+        }
+        long size = 0;
+        long resident = 0;
+        int read = fscanf(statm, "%ld %ld", &size, &resident);
+        fclose(statm);
+        return read == 2 ? (size_t) resident * sysconf(_SC_PAGESIZE) : 0;
+#elif defined(TARGET_OSX) || defined(TARGET_OF_IPHONE) || defined(__APPLE__)
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+        {
+            return 0;
+        }
+        return info.resident_size;
+#else
+        return 0;
+#endif
+    }
+    
+private:
+    void frame()
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        manager.update();
+        manager.draw();
+        windowMicros += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        windowFrames++;
+    }
+    
+    ofxLayerManager &manager;
+    double windowMicros;
+    unsigned long long windowFrames;
+    int numNames;
+    size_t payloadBytes;
+};
+
+#endif
@@ -0,0 +1,278 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#ifndef OFXLAYERTABLE
+#define OFXLAYERTABLE
+
+#include "ofMain.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+struct ofxLayerTableEntry
+{
+    string layerName;
+    bool bActive;
+    bool bSetup;
+    bool bDead;
+    
+    bool operator==(const ofxLayerTableEntry &other) const
+    {
+        return layerName == other.layerName && bActive == other.bActive && bSetup == other.bSetup && bDead == other.bDead;
+    }
+};
+
+//Immutable copy of the manager's layer state, sorted by name like the layer map
+class ofxLayerTable
+{
+public:
+    ofxLayerTable()
+    {
+        version = 0;
+    }
+    
+    const vector<ofxLayerTableEntry>& getEntries() const { return entries; }
+    size_t size() const { return entries.size(); }
+    unsigned long long getVersion() const { return version; }
+    
+    const ofxLayerTableEntry* find(const string &layerName) const
+    {
+        vector<ofxLayerTableEntry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), layerName, compareName);
+        if(it != entries.end() && it->layerName == layerName)
+        {
+            return &(*it);
+        }
+        return NULL;
+    }
+    
+    bool containsLayer(const string &layerName) const { return find(layerName) != NULL; }
+    
+    bool isActive(const string &layerName) const
+    {
+        const ofxLayerTableEntry *e = find(layerName);
+        return e != NULL && e->bActive;
+    }
+    
+    bool isSetup(const string &layerName) const
+    {
+        const ofxLayerTableEntry *e = find(layerName);
+        return e != NULL && e->bSetup;
+    }
+    
+    vector<ofxLayerTableEntry> entries;
+    unsigned long long version;
+    
+private:
+    static bool compareName(const ofxLayerTableEntry &e, const string &layerName) { return e.layerName < layerName; }
+};
+
+//Epoch based reclamation shared by every publisher. A reader thread owns one slot and stores the
+//epoch it entered at, a retired table is freed once every occupied slot has moved past its retire epoch.
+namespace ofxLayerTableEpoch
+{
+    enum { MAX_READER_THREADS = 128 };
+    
+    inline std::atomic<unsigned long long>& global()
+    {
+        static std::atomic<unsigned long long> epoch(1);
+        return epoch;
+    }
+    
+    inline std::atomic<unsigned long long>* slots()
+    {
+        static std::atomic<unsigned long long> readerEpochs[MAX_READER_THREADS];
+        return readerEpochs;
+    }
+    
+    inline std::atomic<bool>* claimed()
+    {
+        static std::atomic<bool> slotClaimed[MAX_READER_THREADS];
+        return slotClaimed;
+    }
+    
+    //per reader thread slot, released when the thread exits
+    struct ThreadSlot
+    {
+        ThreadSlot()
+        {
+            depth = 0;
+            slot = -1;
+            while(slot < 0)
+            {
+                for(int i = 0; i < MAX_READER_THREADS && slot < 0; i++)
+                {
+                    bool expected = false;
+                    if(claimed()[i].compare_exchange_strong(expected, true))
+                    {
+                        slot = i;
+                    }
+                }
+                if(slot < 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        
+        ~ThreadSlot()
+        {
+            slots()[slot].store(0);
+            claimed()[slot].store(false);
+        }
+        
+        int slot;
+        int depth;
+    };
+    
+    inline ThreadSlot& thisThread()
+    {
+        static thread_local ThreadSlot threadSlot;
+        return threadSlot;
+    }
+    
+    inline void enter()
+    {
+        ThreadSlot &t = thisThread();
+        if(t.depth++ == 0)
+        {
+            slots()[t.slot].store(global().load());
+        }
+    }
+    
+    inline void leave()
+    {
+        ThreadSlot &t = thisThread();
+        if(--t.depth == 0)
+        {
+            slots()[t.slot].store(0);
+        }
+    }
+    
+    //oldest epoch any reader is still inside, 0 if there are none
+    inline unsigned long long oldestReader()
+    {
+        unsigned long long oldest = 0;
+        for(int i = 0; i < MAX_READER_THREADS; i++)
+        {
+            unsigned long long e = slots()[i].load();
+            if(e != 0 && (oldest == 0 || e < oldest))
+            {
+                oldest = e;
+            }
+        }
+        return oldest;
+    }
+}
+
+//Single writer (the manager on the main thread) swaps in a new table after every change,
+//any number of threads read the current one without locks and without ever blocking the writer.
+class ofxLayerTablePublisher
+{
+public:
+    ofxLayerTablePublisher()
+    {
+        current.store(new ofxLayerTable());
+    }
+    
+    ~ofxLayerTablePublisher()
+    {
+        //readers have to be gone by now
+        delete current.load();
+        for(size_t i = 0; i < retired.size(); i++)
+        {
+            delete retired[i].first;
+        }
+    }
+    
+    //writer side only
+    const ofxLayerTable& peek() const { return *current.load(); }
+    
+    void publish(ofxLayerTable *table)
+    {
+        table->version = current.load()->version + 1;
+        ofxLayerTable *old = current.exchange(table);
+        retired.push_back(std::make_pair(old, ofxLayerTableEpoch::global().fetch_add(1) + 1));
+        reclaim();
+    }
+    
+    size_t getNumRetired() const { return retired.size(); }
+    
+private:
+    friend class ofxLayerTableReader;
+    
+    void reclaim()
+    {
+        unsigned long long oldest = ofxLayerTableEpoch::oldestReader();
+        size_t kept = 0;
+        for(size_t i = 0; i < retired.size(); i++)
+        {
+            if(oldest == 0 || retired[i].second <= oldest)
+            {
+                delete retired[i].first;
+            }
+            else
+            {
+                retired[kept++] = retired[i];
+            }
+        }
+        retired.resize(kept);
+    }
+    
+    ofxLayerTablePublisher(const ofxLayerTablePublisher&);
+    ofxLayerTablePublisher& operator=(const ofxLayerTablePublisher&);
+    
+    std::atomic<ofxLayerTable*> current;
+    vector<std::pair<ofxLayerTable*, unsigned long long> > retired;
+};
+
+//Pins the current table for as long as it is in scope, from any thread:
+//
+//  ofxLayerTableReader table(manager.getLayerTable());
+//  if(table->isActive("menu")) { ... }
+class ofxLayerTableReader
+{
+public:
+    ofxLayerTableReader(const ofxLayerTablePublisher &publisher)
+    {
+        ofxLayerTableEpoch::enter();
+        table = publisher.current.load();
+    }
+    
+    ~ofxLayerTableReader()
+    {
+        ofxLayerTableEpoch::leave();
+    }
+    
+    const ofxLayerTable& operator*() const { return *table; }
+    const ofxLayerTable* operator->() const { return table; }
+    
+private:
+    ofxLayerTableReader(const ofxLayerTableReader&);
+    ofxLayerTableReader& operator=(const ofxLayerTableReader&);
+    
+    const ofxLayerTable *table;
+};
+
+#endif
@@ -0,0 +1,166 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#ifndef OFXLAYERWORKERPOOL
+#define OFXLAYERWORKERPOOL
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+//Tracks a batch of jobs submitted to an ofxLayerWorkerPool so the caller can wait on just that batch
+class ofxLayerTaskGroup
+{
+public:
+    ofxLayerTaskGroup()
+    {
+        pending = 0;
+    }
+    
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(pending > 0)
+        {
+            done.wait(lock);
+        }
+    }
+    
+    bool isDone()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending == 0;
+    }
+    
+private:
+    friend class ofxLayerWorkerPool;
+    
+    void add()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending++;
+    }
+    
+    void finish()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending--;
+        if(pending == 0)
+        {
+            done.notify_all();
+        }
+    }
+    
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t pending;
+};
+
+//Fixed set of worker threads shared by the manager's parallel paths (exit, draw recording),
+//pipelined updates and asset loads run on pools of their own
+class ofxLayerWorkerPool
+{
+public:
+    ofxLayerWorkerPool(size_t numThreads = 0)
+    {
+        if(numThreads == 0)
+        {
+            numThreads = std::thread::hardware_concurrency();
+        }
+        if(numThreads == 0)
+        {
+            numThreads = 2;
+        }
+        bStop = false;
+        for(size_t i = 0; i < numThreads; i++)
+        {
+            workers.push_back(std::thread(&ofxLayerWorkerPool::work, this));
+        }
+    }
+    
+    ~ofxLayerWorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            bStop = true;
+        }
+        wake.notify_all();
+        for(size_t i = 0; i < workers.size(); i++)
+        {
+            workers[i].join();
+        }
+    }
+    
+    size_t getNumThreads() { return workers.size(); }
+    
+    void run(ofxLayerTaskGroup &group, std::function<void()> job)
+    {
+        group.add();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(Job(&group, job));
+        }
+        wake.notify_one();
+    }
+    
+private:
+    typedef std::pair<ofxLayerTaskGroup*, std::function<void()> > Job;
+    
+    void work()
+    {
+        while(true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while(!bStop && jobs.empty())
+                {
+                    wake.wait(lock);
+                }
+                if(jobs.empty())
+                {
+                    return;
+                }
+                job = jobs.front();
+                jobs.pop_front();
+            }
+            job.second();
+            job.first->finish();
+        }
+    }
+    
+    ofxLayerWorkerPool(const ofxLayerWorkerPool&);
+    ofxLayerWorkerPool& operator=(const ofxLayerWorkerPool&);
+    
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool bStop;
+};
+
+#endif
@@ -0,0 +1,445 @@
+/********************************************************************************** 
+ 
+ Copyright (C) 2012 Syed Reza Ali (www.syedrezaali.com)
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ of the Software, and to permit persons to whom the Software is furnished to do
+ so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ 
+ **********************************************************************************/
+
+#ifndef OFXSTATICLAYERMANAGER
+#define OFXSTATICLAYERMANAGER
+
+//Needs C++17 (fold expressions, if constexpr)
+
+#include "ofxLayer.h"
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+//ofxStaticLayerOverrides_hook<T>::value is false when T just inherits ofxLayer's empty hook,
+//the static manager then doesn't generate a call for it at all. An overloaded hook counts as overridden.
+#define OFX_STATIC_LAYER_HOOK(hook, pointerType) \
+    template<class T, class = void> struct ofxStaticLayerOverrides_##hook : std::true_type {}; \
+    template<class T> struct ofxStaticLayerOverrides_##hook<T, std::void_t<decltype(&T::hook)> > \
+        : std::bool_constant<!std::is_same<decltype(&T::hook), pointerType>::value> {};
+
+OFX_STATIC_LAYER_HOOK(setup, void (ofxLayer::*)())
+OFX_STATIC_LAYER_HOOK(update, void (ofxLayer::*)())
+OFX_STATIC_LAYER_HOOK(draw, void (ofxLayer::*)())
+OFX_STATIC_LAYER_HOOK(exit, void (ofxLayer::*)())
+OFX_STATIC_LAYER_HOOK(touchDown, void (ofxLayer::*)(ofTouchEventArgs&))
+OFX_STATIC_LAYER_HOOK(touchMoved, void (ofxLayer::*)(ofTouchEventArgs&))
+OFX_STATIC_LAYER_HOOK(touchUp, void (ofxLayer::*)(ofTouchEventArgs&))
+OFX_STATIC_LAYER_HOOK(touchDoubleTap, void (ofxLayer::*)(ofTouchEventArgs&))
+OFX_STATIC_LAYER_HOOK(touchCancelled, void (ofxLayer::*)(ofTouchEventArgs&))
+#ifndef TARGET_OPENGLES
+OFX_STATIC_LAYER_HOOK(mouseReleased, void (ofxLayer::*)(ofMouseEventArgs&))
+OFX_STATIC_LAYER_HOOK(mousePressed, void (ofxLayer::*)(ofMouseEventArgs&))
+OFX_STATIC_LAYER_HOOK(mouseMoved, void (ofxLayer::*)(ofMouseEventArgs&))
+OFX_STATIC_LAYER_HOOK(mouseDragged, void (ofxLayer::*)(ofMouseEventArgs&))
+OFX_STATIC_LAYER_HOOK(keyPressed, void (ofxLayer::*)(int))
+OFX_STATIC_LAYER_HOOK(keyReleased, void (ofxLayer::*)(int))
+OFX_STATIC_LAYER_HOOK(windowResized, void (ofxLayer::*)(int, int))
+#endif
+
+//Fixed set of layers held by value. Every hook call is generated per layer type at compile time and made
+//non virtually, layers are addressed by type or index instead of by name:
+//
+//  ofxStaticLayerManager<MenuLayer, GameLayer> layers;
+//  layers.switchLayer<GameLayer>();
+//  layers.get<0>().isActive();
+//
+//Activation works like ofxLayerManager: first activation calls setup(), switchLayer deactivates every
+//set up layer first, and the layers' own switchLayer/activateLayer/deleteMe events are honoured by name.
+//deleteMe() can't free a by-value layer, the layer gets exit() and goes back to not being set up.
+template<class... Layers>
+class ofxStaticLayerManager
+{
+public:
+    static_assert(sizeof...(Layers) > 0, "ofxStaticLayerManager needs at least one layer");
+    static_assert((std::is_base_of<ofxLayer, Layers>::value && ...), "ofxStaticLayerManager layers have to derive from ofxLayer");
+    
+    static constexpr size_t size() { return sizeof...(Layers); }
+    
+    template<size_t I>
+    using layer_type = typename std::tuple_element<I, std::tuple<Layers...> >::type;
+    
+    template<class T>
+    static constexpr size_t indexOf()
+    {
+        static_assert(((std::is_same<T, Layers>::value ? 1 : 0) + ...) == 1, "layer type has to appear exactly once");
+        size_t index = 0;
+        size_t i = 0;
+        ((std::is_same<T, Layers>::value ? (index = i++) : i++), ...);
+        return index;
+    }
+    
+    ofxStaticLayerManager()
+    {
+        windowWidth = -1;
+        windowHeight = -1;
+        bResizePending = false;
+        forEachLayer([this](ofxLayer &l)
+        {
+            l.setManager(NULL);
+            ofAddListener(l.switchLayerEvent, this, &ofxStaticLayerManager::onSwitchLayer);
+            ofAddListener(l.activateLayerEvent, this, &ofxStaticLayerManager::onActivateLayer);
+            ofAddListener(l.deactivateLayerEvent, this, &ofxStaticLayerManager::onDeactivateLayer);
+            ofAddListener(l.deleteLayerEvent, this, &ofxStaticLayerManager::onDeleteLayer);
+        });
+        enableAppEventCallbacks();
+#ifdef TARGET_OPENGLES
+        enableTouchCallbacks();
+#else
+        enableMouseEventCallbacks();
+        enableKeyEventCallbacks();
+        enableWindowEventCallbacks();
+#endif
+    }
+    
+    ~ofxStaticLayerManager()
+    {
+        disableAppEventCallbacks();
+#ifdef TARGET_OPENGLES
+        disableTouchCallbacks();
+#else
+        disableMouseEventCallbacks();
+        disableKeyEventCallbacks();
+        disableWindowEventCallbacks();
+#endif
+        forEachLayer([this](ofxLayer &l)
+        {
+            ofRemoveListener(l.switchLayerEvent, this, &ofxStaticLayerManager::onSwitchLayer);
+            ofRemoveListener(l.activateLayerEvent, this, &ofxStaticLayerManager::onActivateLayer);
+            ofRemoveListener(l.deactivateLayerEvent, this, &ofxStaticLayerManager::onDeactivateLayer);
+            ofRemoveListener(l.deleteLayerEvent, this, &ofxStaticLayerManager::onDeleteLayer);
+        });
+    }
+    
+    void setSharedAppData(ofxSharedAppData* sharedAppData)
+    {
+        forEachLayer([sharedAppData](ofxLayer &l) { l.setSharedAppData(sharedAppData); });
+    }
+    
+    //Layer Access
+    
+    template<class T> T& get() { return std::get<T>(layers); }
+    template<size_t I> layer_type<I>& get() { return std::get<I>(layers); }
+    
+    template<class T> void activateLayer() { setupAndActivate(get<T>()); }
+    template<size_t I> void activateLayer() { setupAndActivate(get<I>()); }
+    
+    template<class T> void deactivateLayer() { get<T>().deactivate(); }
+    template<size_t I> void deactivateLayer() { get<I>().deactivate(); }
+    
+    template<class T> void switchLayer()
+    {
+        deactivateAll();
+        setupAndActivate(get<T>());
+    }
+    
+    template<size_t I> void switchLayer()
+    {
+        deactivateAll();
+        setupAndActivate(get<I>());
+    }
+    
+    void switchLayer(string name)
+    {
+        if(containsLayer(name))
+        {
+            deactivateAll();
+            forNamedLayer(name, [this](auto &l) { setupAndActivate(l); });
+        }
+    }
+    
+    bool containsLayer(string name)
+    {
+        bool bFound = false;
+        forEachLayer([&](ofxLayer &l) { bFound = bFound || l.getLayerName() == name; });
+        return bFound;
+    }
+    
+    //first active layer in declaration order, NULL if none
+    ofxLayer *getActiveLayer()
+    {
+        ofxLayer *active = NULL;
+        forEachLayer([&](ofxLayer &l) { if(active == NULL && l.isActive()) { active = &l; } });
+        return active;
+    }
+    
+    template<class F>
+    void forEachLayer(F &&f)
+    {
+        std::apply([&f](auto&... l) { (f(l), ...); }, layers);
+    }
+    
+    //App Callbacks
+    
+    void enableAppEventCallbacks()
+    {
+        ofAddListener(ofEvents().update, this, &ofxStaticLayerManager::onUpdate);
+        ofAddListener(ofEvents().draw, this, &ofxStaticLayerManager::onDraw);
+        ofAddListener(ofEvents().exit, this, &ofxStaticLayerManager::onExit);
+    }
+    
+    void disableAppEventCallbacks()
+    {
+        ofRemoveListener(ofEvents().update, this, &ofxStaticLayerManager::onUpdate);
+        ofRemoveListener(ofEvents().draw, this, &ofxStaticLayerManager::onDraw);
+        ofRemoveListener(ofEvents().exit, this, &ofxStaticLayerManager::onExit);
+    }
+    
+    void onUpdate(ofEventArgs &data) { update(); }
+    void onDraw(ofEventArgs &data) { draw(); }
+    void onExit(ofEventArgs &data) { exit(); }
+    
+    void update()
+    {
+        flushPendingLayout();
+        forEachLayer([this](auto &l)
+        {
+            using T = std::decay_t<decltype(l)>;
+            if(l.isDead())
+            {
+                retire(l);
+            }
+            else if constexpr (ofxStaticLayerOverrides_update<T>::value)
+            {
+                if(l.isActive()) { l.T::update(); }
+            }
+        });
+    }
+    
+    void draw()
+    {
+        forEachLayer([](auto &l)
+        {
+            using T = std::decay_t<decltype(l)>;
+            if constexpr (ofxStaticLayerOverrides_draw<T>::value)
+            {
+                if(l.isActive()) { l.T::draw(); }
+            }
+        });
+    }
+    
+    void exit()
+    {
+        disableAppEventCallbacks();
+        forEachLayer([this](auto &l) { retire(l); });
+    }
+    
+#define OFX_STATIC_LAYER_DISPATCH(hook, arg) \
+        forEachLayer([&](auto &l) \
+        { \
+            using T = std::decay_t<decltype(l)>; \
+            if constexpr (ofxStaticLayerOverrides_##hook<T>::value) \
+            { \
+                if(l.isActive()) { l.T::hook(arg); } \
+            } \
+        });
+    
+#ifdef TARGET_OPENGLES
+    //Touch Callbacks
+    void enableTouchCallbacks()
+    {
+        ofAddListener(ofEvents().touchUp, this, &ofxStaticLayerManager::onTouchUp);
+        ofAddListener(ofEvents().touchDown, this, &ofxStaticLayerManager::onTouchDown);
+        ofAddListener(ofEvents().touchMoved, this, &ofxStaticLayerManager::onTouchMoved);
+        ofAddListener(ofEvents().touchCancelled, this, &ofxStaticLayerManager::onTouchCancelled);
+        ofAddListener(ofEvents().touchDoubleTap, this, &ofxStaticLayerManager::onTouchDoubleTap);
+    }
+    
+    void disableTouchCallbacks()
+    {
+        ofRemoveListener(ofEvents().touchUp, this, &ofxStaticLayerManager::onTouchUp);
+        ofRemoveListener(ofEvents().touchDown, this, &ofxStaticLayerManager::onTouchDown);
+        ofRemoveListener(ofEvents().touchMoved, this, &ofxStaticLayerManager::onTouchMoved);
+        ofRemoveListener(ofEvents().touchCancelled, this, &ofxStaticLayerManager::onTouchCancelled);
+        ofRemoveListener(ofEvents().touchDoubleTap, this, &ofxStaticLayerManager::onTouchDoubleTap);
+    }
+    
+    void onTouchUp(ofTouchEventArgs &data) { OFX_STATIC_LAYER_DISPATCH(touchUp, data) }
+    void onTouchDown(ofTouchEventArgs &data) { OFX_STATIC_LAYER_DISPATCH(touchDown, data) }
+    void onTouchMoved(ofTouchEventArgs &data) { OFX_STATIC_LAYER_DISPATCH(touchMoved, data) }
+    void onTouchCancelled(ofTouchEventArgs &data) { OFX_STATIC_LAYER_DISPATCH(touchCancelled, data) }
+    void onTouchDoubleTap(ofTouchEventArgs &data) { OFX_STATIC_LAYER_DISPATCH(touchDoubleTap, data) }
+#else
+    //Keyboard Callbacks
+    void enableKeyEventCallbacks()
+    {
+        ofAddListener(ofEvents().keyPressed, this, &ofxStaticLayerManager::onKeyPressed);
+        ofAddListener(ofEvents().keyReleased, this, &ofxStaticLayerManager::onKeyReleased);
+    }
+    
+    void disableKeyEventCallbacks()
+    {
+        ofRemoveListener(ofEvents().keyPressed, this, &ofxStaticLayerManager::onKeyPressed);
+        ofRemoveListener(ofEvents().keyReleased, this, &ofxStaticLayerManager::onKeyReleased);
+    }
+    
+    void onKeyPressed(ofKeyEventArgs& data) { OFX_STATIC_LAYER_DISPATCH(keyPressed, data.key) }
+    void onKeyReleased(ofKeyEventArgs& data) { OFX_STATIC_LAYER_DISPATCH(keyReleased, data.key) }
+    
+    //Mouse Callbacks
+    void enableMouseEventCallbacks()
+    {
+        ofAddListener(ofEvents().mouseReleased, this, &ofxStaticLayerManager::onMouseReleased);
+        ofAddListener(ofEvents().mousePressed, this, &ofxStaticLayerManager::onMousePressed);
+        ofAddListener(ofEvents().mouseMoved, this, &ofxStaticLayerManager::onMouseMoved);
+        ofAddListener(ofEvents().mouseDragged, this, &ofxStaticLayerManager::onMouseDragged);
+    }
+    
+    void disableMouseEventCallbacks()
+    {
+        ofRemoveListener(ofEvents().mouseReleased, this, &ofxStaticLayerManager::onMouseReleased);
+        ofRemoveListener(ofEvents().mousePressed, this, &ofxStaticLayerManager::onMousePressed);
+        ofRemoveListener(ofEvents().mouseMoved, this, &ofxStaticLayerManager::onMouseMoved);
+        ofRemoveListener(ofEvents().mouseDragged, this, &ofxStaticLayerManager::onMouseDragged);
+    }
+    
+    void onMouseReleased(ofMouseEventArgs& data) { OFX_STATIC_LAYER_DISPATCH(mouseReleased, data) }
+    void onMousePressed(ofMouseEventArgs& data) { OFX_STATIC_LAYER_DISPATCH(mousePressed, data) }
+    void onMouseMoved(ofMouseEventArgs& data) { OFX_STATIC_LAYER_DISPATCH(mouseMoved, data) }
+    void onMouseDragged(ofMouseEventArgs& data) { OFX_STATIC_LAYER_DISPATCH(mouseDragged, data) }
+    
+    //Window Resize Callback, coalesced per frame like ofxLayerManager
+    void enableWindowEventCallbacks()
+    {
+        ofAddListener(ofEvents().windowResized, this, &ofxStaticLayerManager::onWindowResized);
+    }
+    
+    void disableWindowEventCallbacks()
+    {
+        ofRemoveListener(ofEvents().windowResized, this, &ofxStaticLayerManager::onWindowResized);
+    }
+    
+    void onWindowResized(ofResizeEventArgs& data)
+    {
+        pendingWidth = data.width;
+        pendingHeight = data.height;
+        bResizePending = true;
+    }
+#endif
+#undef OFX_STATIC_LAYER_DISPATCH
+    
+    //Layer Events, these come in by name so they are resolved at runtime
+    
+    void onActivateLayer(ofxLayerEventArgs &args)
+    {
+        forNamedLayer(args.layerName, [this](auto &l) { setupAndActivate(l); });
+    }
+    
+    void onDeactivateLayer(ofxLayerEventArgs &args)
+    {
+        forNamedLayer(args.layerName, [](auto &l) { l.deactivate(); });
+    }
+    
+    void onSwitchLayer(ofxLayerEventArgs &args)
+    {
+        if(containsLayer(args.layerName))
+        {
+            args.sender->deactivate();
+            forNamedLayer(args.layerName, [this](auto &l) { setupAndActivate(l); });
+        }
+    }
+    
+    void onDeleteLayer(ofxLayerEventArgs &args)
+    {
+        forNamedLayer(args.layerName, [](auto &l) { l.setDead(true); });
+    }
+    
+private:
+    template<class F>
+    void forNamedLayer(const string &name, F &&f)
+    {
+        forEachLayer([&](auto &l) { if(l.getLayerName() == name) { f(l); } });
+    }
+    
+    void deactivateAll()
+    {
+        forEachLayer([](ofxLayer &l) { if(l.isSetup()) { l.deactivate(); } });
+    }
+    
+    template<class T>
+    void setupAndActivate(T &l)
+    {
+        if(!l.isSetup())
+        {
+            if constexpr (ofxStaticLayerOverrides_setup<T>::value) { l.T::setup(); }
+            l.setSetup(true);
+            l.setLayoutSize(windowWidth >= 0 ? windowWidth : ofGetWidth(), windowHeight >= 0 ? windowHeight : ofGetHeight());
+        }
+        else
+        {
+            layoutLayer(l);
+        }
+        l.T::activate();
+    }
+    
+    //exit() and back to not set up, the static counterpart of deleting a layer
+    template<class T>
+    void retire(T &l)
+    {
+        if(l.isSetup())
+        {
+            if(l.isActive()) { l.T::deactivate(); }
+            if constexpr (ofxStaticLayerOverrides_exit<T>::value) { l.T::exit(); }
+            l.setSetup(false);
+        }
+        l.setDead(false);
+    }
+    
+    template<class T>
+    void layoutLayer(T &l)
+    {
+#ifndef TARGET_OPENGLES
+        if(windowWidth >= 0 && (l.getLayoutWidth() != windowWidth || l.getLayoutHeight() != windowHeight))
+        {
+            l.setLayoutSize(windowWidth, windowHeight);
+            if constexpr (ofxStaticLayerOverrides_windowResized<T>::value) { l.T::windowResized(windowWidth, windowHeight); }
+        }
+#endif
+    }
+    
+    void flushPendingLayout()
+    {
+        if(!bResizePending)
+        {
+            return;
+        }
+        windowWidth = pendingWidth;
+        windowHeight = pendingHeight;
+        bResizePending = false;
+        forEachLayer([this](auto &l) { if(l.isSetup() && l.isActive()) { layoutLayer(l); } });
+    }
+    
+    ofxStaticLayerManager(const ofxStaticLayerManager&);
+    ofxStaticLayerManager& operator=(const ofxStaticLayerManager&);
+    
+    std::tuple<Layers...> layers;
+    
+    int windowWidth;
+    int windowHeight;
+    int pendingWidth;
+    int pendingHeight;
+    bool bResizePending;
+};
+
+#endif